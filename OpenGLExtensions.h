@@ -38,6 +38,7 @@ PFNGLDEBUGMESSAGECALLBACKPROC		glDebugMessageCallback = nullptr;
 PFNGLBUFFERSUBDATAPROC				glBufferSubData = nullptr;
 PFNGLUNIFORMBLOCKBINDINGPROC		glUniformBlockBinding = nullptr;
 PFNGLBINDBUFFERBASEPROC				glBindBufferBase = nullptr;
+PFNGLBINDBUFFERRANGEPROC			glBindBufferRange = nullptr;
 PFNGLGETUNIFORMBLOCKINDEXPROC		glGetUniformBlockIndex = nullptr;
 
 void QueryOGLExtensionFunctions(GW::GRAPHICS::GOpenGLSurface ogl)
@@ -72,6 +73,7 @@ void QueryOGLExtensionFunctions(GW::GRAPHICS::GOpenGLSurface ogl)
 	ogl.QueryExtensionFunction(nullptr, "glBufferSubData", (void**)&glBufferSubData);
 	ogl.QueryExtensionFunction(nullptr, "glUniformBlockBinding", (void**)&glUniformBlockBinding);
 	ogl.QueryExtensionFunction(nullptr, "glBindBufferBase", (void**)&glBindBufferBase);
+	ogl.QueryExtensionFunction(nullptr, "glBindBufferRange", (void**)&glBindBufferRange);
 	ogl.QueryExtensionFunction(nullptr, "glGetUniformBlockIndex", (void**)&glGetUniformBlockIndex);
 }
 #endif
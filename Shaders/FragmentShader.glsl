@@ -1,4 +1,4 @@
-#version 420 // GLSL 4.20
+#version 430 // GLSL 4.30 (shader storage buffers)
 // an ultra simple glsl fragment shader
 
 //Out Pixel Info
@@ -22,9 +22,7 @@ struct OBJ_ATTRIBUTES
 layout(row_major, binding = 1) uniform SceneData
 {
 	vec4 sunDirection, sunColor;
-	mat4 viewMatrix, projectionMatrix;
-	mat4 minimapViewMatrix, minimapProjectionMatrix;
-	vec4 minimapCameraPos; //Minimap Camera POS
+	mat4 viewMatrix, projectionMatrix; //The minimap swaps its own view in
 	vec4 cameraPos;
 	vec4 sunAmbient;
 };
@@ -33,30 +31,86 @@ layout(row_major, binding = 2) uniform ModelData
 {
 	mat4 worldMatrix;
 	OBJ_ATTRIBUTES material;
+	vec4 positionOffset; //Compact vertices: position = offset + stored * scale (0 for float vertices)
+	vec4 positionScale; //Compact vertices: size of the mesh bounds (1 for float vertices)
+	vec4 uvTransform; //Compact vertices: uv offset (xy) & scale (zw)
+	uvec4 vertexFormat; //x: 0 = 36 byte float vertices, 1 = 16 byte compact vertices
+};
+
+//SSBO #3 - Lights of the level, directional ones first
+struct LIGHT
+{
+	vec4 position; //xyz world position, w range (0 for directional lights)
+	vec4 color; //rgb color * intensity
+	vec4 direction; //xyz direction the light shines in, w cosine of the spot cone (-1 lights every direction)
+};
+layout(std430, binding = 3) readonly buffer Lights
+{
+	LIGHT lights[];
+};
+//SSBO #4 - Froxel grid of the view (see light_grid.h)
+layout(std430, binding = 4) readonly buffer LightClusters
+{
+	uvec4 clusterGrid; //tiles x, tiles y, depth slices, directional light count
+	vec4 clusterDepth; //slice = floor(log(view depth) * x + y)
+	vec4 clusterViewport; //x, y, 1 / width, 1 / height
+	uvec2 clusters[]; //offset into lightIndices & light count of each froxel
+};
+//SSBO #5 - Point & spot lights of every froxel
+layout(std430, binding = 5) readonly buffer LightIndices
+{
+	uint lightIndices[];
 };
 
 //In Vector Info
 in vec3 worldNorm;
 in vec3 worldPos;
 
+//Adds the diffuse & specular light of one light, toLight is normalized
+void AddLight(vec3 normal, vec3 viewDir, vec3 toLight, vec3 radiance, inout vec3 totalDirect, inout vec3 totalReflected)
+{
+	totalDirect += clamp(dot(toLight, normal), 0, 1) * radiance;
+	//HALFVECTOR = NORMALIZE(LIGHTDIR + VIEWDIR), INTENSITY = CLAMP(DOT(NORMAL, HALFVECTOR))^SPECULARPOWER
+	vec3 halfVector = normalize(toLight + viewDir);
+	float intensity = max(pow(clamp(dot(normal, halfVector), 0, 1), material.Ns + 0.00001), 0);
+	totalReflected += radiance * material.Ks * intensity;
+}
+
 void main()
 {
-	//Applying the Directional Light
-	float lightRatio = clamp(dot(normalize(-sunDirection.xyz), normalize(worldNorm.xyz)), 0, 1);
-	vec3 totalDirect = clamp((lightRatio * sunColor.xyz), 0, 1);
+	vec3 normal = normalize(worldNorm.xyz);
+	//VIEWDIR = NORMALIZE(CAMWORLDPOS - SURFACEPOS)
+	vec3 viewDir = normalize(cameraPos.xyz - worldPos.xyz);
+	vec3 totalDirect = vec3(0);
+	vec3 totalReflected = vec3(0);
+
+	//Directional lights reach every fragment
+	for (uint i = 0u; i < clusterGrid.w; ++i)
+		AddLight(normal, viewDir, -lights[i].direction.xyz, lights[i].color.xyz, totalDirect, totalReflected);
+
+	//Point & spot lights of this fragment's froxel
+	float viewDepth = max(-(vec4(worldPos, 1) * viewMatrix).z, clusterDepth.z);
+	uvec3 froxel = uvec3(clamp(ivec3(ivec2((gl_FragCoord.xy - clusterViewport.xy) * clusterViewport.zw * vec2(clusterGrid.xy)),
+		int(log(viewDepth) * clusterDepth.x + clusterDepth.y)), ivec3(0), ivec3(clusterGrid.xyz) - 1));
+	uvec2 cluster = clusters[froxel.x + clusterGrid.x * (froxel.y + clusterGrid.y * froxel.z)];
+	for (uint i = cluster.x; i < cluster.x + cluster.y; ++i)
+	{
+		LIGHT light = lights[lightIndices[i]];
+		vec3 toLight = light.position.xyz - worldPos.xyz;
+		float lightDistance = length(toLight);
+		toLight /= max(lightDistance, 0.0001);
+		//Fade to nothing at the light's range, roughly inverse square before that
+		float fade = clamp(1 - pow(lightDistance / light.position.w, 4), 0, 1);
+		float attenuation = fade * fade / (lightDistance * lightDistance + 1);
+		//Spot lights fade out over the last 10% of their cone
+		if (light.direction.w > -1)
+			attenuation *= clamp((dot(-toLight, light.direction.xyz) - light.direction.w) / (0.1 * (1 - light.direction.w)), 0, 1);
+		AddLight(normal, viewDir, toLight, light.color.xyz * attenuation, totalDirect, totalReflected);
+	}
 	vec3 totalIndirect = clamp((material.Ka.xyz * sunAmbient.xyz), 0, 1);
 	vec3 diffuse = material.Kd;
-	//VIEWDIR = NORMALIZE(CAMWORLDPOS  SURFACEPOS)
-	vec4 camWorldPos = cameraPos;
-	vec3 viewDir = normalize(camWorldPos.xyz - worldPos.xyz);
-	//HALFVECTOR = NORMALIZE((-LIGHTDIR) + VIEWDIR)
-	vec3 halfVector = normalize((-normalize(sunDirection.xyz)) + viewDir);
-	//INTENSITY = MAX(CLAMP(DOT(NORMAL, HALFVECTOR))SPECULARPOWER, 0);
-	float intensity = max(pow((clamp(dot(normalize(worldNorm.xyz), halfVector), 0, 1)), material.Ns + 0.00001), 0);
-	//REFLECTEDLIGHT = LIGHTCOLOR * SPECULARINTENSITY * INTENSITY;
-	vec3 totalReflected = sunColor.xyz * material.Ks * intensity;
 	//Put it all together
 	//RETURN SATURATE(TOTALDIRECT + TOTALINDIRECT) * DIFFUSE + TOTALREFLECTED + EMISSIVE
-	Pixel = vec4(clamp((totalDirect + totalIndirect), 0, 1) * diffuse + totalReflected + material.Ke, material.d);
+	Pixel = vec4(clamp((clamp(totalDirect, 0, 1) + totalIndirect), 0, 1) * diffuse + totalReflected + material.Ke, material.d);
 
 }
\ No newline at end of file
@@ -19,9 +19,7 @@ struct OBJ_ATTRIBUTES
 layout(row_major, binding = 1) uniform SceneData
 {
 	vec4 sunDirection, sunColor;
-	mat4 viewMatrix, projectionMatrix;
-	mat4 minimapViewMatrix, minimapProjectionMatrix;
-	vec4 minimapCameraPos; //Minimap Camera POS
+	mat4 viewMatrix, projectionMatrix; //The minimap swaps its own view in
 	vec4 cameraPos;
 	vec4 sunAmbient;
 };
@@ -30,6 +28,10 @@ layout(row_major, binding = 2) uniform ModelData
 {
 	mat4 worldMatrix;
 	OBJ_ATTRIBUTES material;
+	vec4 positionOffset; //Compact vertices: position = offset + stored * scale (0 for float vertices)
+	vec4 positionScale; //Compact vertices: size of the mesh bounds (1 for float vertices)
+	vec4 uvTransform; //Compact vertices: uv offset (xy) & scale (zw)
+	uvec4 vertexFormat; //x: 0 = 36 byte float vertices, 1 = 16 byte compact vertices
 };
 
 //In Vector Info
@@ -41,12 +43,26 @@ layout(location = 2) in vec3 norms;
 out vec3 worldNorm;
 out vec3 worldPos;
 
+//Decodes an octahedral encoded normal (compact vertices)
+vec3 OctDecode(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += (n.x >= 0.0) ? -t : t;
+	n.y += (n.y >= 0.0) ? -t : t;
+	return normalize(n);
+}
+
 void main()
 {
-	vec4 tempNorm = vec4(norms, 0);//Create a temp value to store the normals in
+	//Undo the compact vertex quantization (offset 0 & scale 1 leave float vertices untouched)
+	vec3 position = positionOffset.xyz + local_pos * positionScale.xyz;
+	vec3 normal = (vertexFormat.x == 1u) ? OctDecode(norms.xy) : norms;
+
+	vec4 tempNorm = vec4(normal, 0);//Create a temp value to store the normals in
 	worldNorm = (tempNorm * worldMatrix).xyz; //Put the normals into world space, and pass it out to worldNorm
 
-	vec4 tempPos = vec4(local_pos, 1); //Create a temp value to store the positions in
+	vec4 tempPos = vec4(position, 1); //Create a temp value to store the positions in
 	worldPos = (tempPos * worldMatrix).xyz; //Put the positions into world space, and pass it out to worldPos
 
 	gl_Position = tempPos * worldMatrix * viewMatrix * projectionMatrix; //Set gl_Position into projection space
@@ -0,0 +1,65 @@
+// Converts .h2b files between the original sequential "019d" layout and the H2B v2 container.
+// Usage: H2B_Convert [--to-v2 | --to-v1] <input .h2b or folder> <output .h2b or folder>
+// Every written file is parsed back and compared against its source before it counts as converted.
+#include <cstdio>
+#include "h2bToolsCommon.h"
+#include "../h2bWriter.h"
+
+//Converts one file, returns false if it could not be read, written or verified
+bool ConvertFile(const std::string& input, const std::string& output, bool toV2)
+{
+	H2B::Parser source;
+	if (!source.Parse(input.c_str())) {
+		std::printf("ERROR: could not parse %s\n", input.c_str());
+		return false;
+	}
+	H2B::FILE_DATA data = H2B::GetFileData(source);
+	// optional v2 sections (meshlets...) are carried over, v1 has no place for them
+	if (!(toV2 ? H2B::WriteV2(output.c_str(), data, source.extraSections) : H2B::WriteV1(output.c_str(), data))) {
+		std::printf("ERROR: could not write %s\n", output.c_str());
+		return false;
+	}
+	// the output must read back to exactly the same data, through both the copying and the mapped parser
+	H2B::Parser check;
+	H2B::MappedParser mapped;
+	if (!check.Parse(output.c_str()) || !SameResult(source, check) || !mapped.Parse(output.c_str()) ||
+		mapped.vertexCount != source.vertexCount || mapped.indexCount != source.indexCount) {
+		std::printf("ERROR: %s does not match %s after conversion\n", output.c_str(), input.c_str());
+		return false;
+	}
+	std::printf("%-48s %8llu -> %8llu bytes (%s)\n", std::filesystem::path(input).filename().string().c_str(),
+		static_cast<unsigned long long>(std::filesystem::file_size(input)),
+		static_cast<unsigned long long>(std::filesystem::file_size(output)), toV2 ? "v2" : "v1");
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool toV2 = true;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--to-v2") == 0)
+			toV2 = true;
+		else if (std::strcmp(argv[i], "--to-v1") == 0)
+			toV2 = false;
+		else
+			paths.push_back(argv[i]);
+	}
+	if (paths.size() != 2) {
+		std::printf("Usage: H2B_Convert [--to-v2 | --to-v1] <input .h2b or folder> <output .h2b or folder>\n");
+		return 1;
+	}
+
+	int failures = 0;
+	std::error_code error;
+	if (std::filesystem::is_directory(paths[0], error)) {
+		std::filesystem::create_directories(paths[1], error);
+		for (auto& file : ListH2BFiles({ paths[0] })) {
+			std::string output = (std::filesystem::path(paths[1]) / std::filesystem::path(file).filename()).string();
+			failures += ConvertFile(file, output, toV2) ? 0 : 1;
+		}
+	}
+	else
+		failures += ConvertFile(paths[0], paths[1], toV2) ? 0 : 1;
+	return failures == 0 ? 0 : 1;
+}
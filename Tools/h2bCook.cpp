@@ -0,0 +1,145 @@
+// Offline cook step: runs the H2B::Optimize passes over .h2b files and writes the result.
+// Usage: H2B_Cook [--weld] [--vcache] [--overdraw[=threshold]] [--meshlets] [--vfetch] [--lods[=count]] [--to-v2 | --to-v1] <input .h2b or folder> <output .h2b or folder>
+// With no pass selected every pass runs. Prints the vertex count and vertex cache ACMR/ATVR before and after each file,
+// the CPU estimated overdraw when the overdraw pass runs, the meshlet count when meshlets are built and the triangle count
+// & error (model units and % of the mesh size) of every simplified level.
+// Meshlets and levels of detail are stored as v2 SECTION_MESHLETS & SECTION_LODS, so they are dropped when writing v1.
+#include <cstdio>
+#include <cstdlib>
+#include "h2bToolsCommon.h"
+#include "../h2bOptimize.h"
+#include "../h2bWriter.h"
+
+//Returns true if every range of "cooked" draws the same triangles (same winding) as in "source"
+//Triangles are compared by their vertices' contents, so welding & vertex reordering are allowed
+bool SameTriangles(const H2B::Parser& source, const H2B::Parser& cooked)
+{
+	if (source.indexCount != cooked.indexCount)
+		return false;
+	struct TRIANGLE {
+		H2B::VERTEX v[3];
+		bool operator<(const TRIANGLE& o) const { return std::memcmp(v, o.v, sizeof(v)) < 0; }
+		bool operator!=(const TRIANGLE& o) const { return std::memcmp(v, o.v, sizeof(v)) != 0; }
+	};
+	auto less = [](const H2B::VERTEX& a, const H2B::VERTEX& b) { return std::memcmp(&a, &b, sizeof(H2B::VERTEX)) < 0; };
+	auto collect = [&](const H2B::Parser& p, const H2B::BATCH& r) {
+		std::vector<TRIANGLE> triangles(r.indexCount / 3);
+		for (size_t t = 0; t < triangles.size(); ++t) {
+			const H2B::VERTEX* v[3];
+			for (int k = 0; k < 3; ++k)
+				v[k] = &p.vertices[p.indices[r.indexOffset + t * 3 + k]];
+			// rotate the smallest vertex first so the winding is kept but the starting corner doesn't matter
+			int first = (!less(*v[1], *v[0]) && !less(*v[2], *v[0])) ? 0 : (!less(*v[2], *v[1]) ? 1 : 2);
+			for (int k = 0; k < 3; ++k)
+				triangles[t].v[k] = *v[(first + k) % 3];
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	for (auto& r : H2B::GetIndexRanges(source.batches, source.meshes, source.indexCount)) {
+		std::vector<TRIANGLE> a = collect(source, r), b = collect(cooked, r);
+		for (size_t t = 0; t < a.size(); ++t)
+			if (a[t] != b[t])
+				return false;
+	}
+	return true;
+}
+
+//Cooks one file, returns false if it could not be read, written or verified
+bool CookFile(const std::string& input, const std::string& output, const H2B::OPTIMIZE_OPTIONS& options, bool toV2)
+{
+	H2B::Parser source, cooked;
+	if (!source.Parse(input.c_str()) || !cooked.Parse(input.c_str())) {
+		std::printf("ERROR: could not parse %s\n", input.c_str());
+		return false;
+	}
+	H2B::OPTIMIZE_REPORT report;
+	H2B::Optimize(cooked, options, &report);
+	if (!SameTriangles(source, cooked)) {
+		std::printf("ERROR: optimizing %s changed its triangles\n", input.c_str());
+		return false;
+	}
+	H2B::FILE_DATA data = H2B::GetFileData(cooked);
+	if (!(toV2 ? H2B::WriteV2(output.c_str(), data, cooked.extraSections) : H2B::WriteV1(output.c_str(), data))) {
+		std::printf("ERROR: could not write %s\n", output.c_str());
+		return false;
+	}
+	H2B::Parser check;
+	if (!check.Parse(output.c_str()) || !SameResult(cooked, check)) {
+		std::printf("ERROR: %s does not read back correctly\n", output.c_str());
+		return false;
+	}
+	H2B::LOD_CHAIN lods;
+	const H2B::EXTRA_SECTION* lodSection = check.FindSection(H2B::SECTION_LODS);
+	if (lodSection && !H2B::ReadLodSection(lodSection->data.data(), lodSection->data.size(), check.vertexCount,
+		static_cast<unsigned>(check.meshes.size()), lods)) {
+		std::printf("ERROR: %s has a malformed SECTION_LODS\n", output.c_str());
+		return false;
+	}
+	std::printf("%-32s %6u tris  verts %6u -> %6u  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f", std::filesystem::path(input).filename().string().c_str(),
+		source.indexCount / 3, report.verticesBefore, report.verticesAfter, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+	if (options.overdraw)
+		std::printf("  Overdraw %.3f -> %.3f", report.overdrawBefore.overdraw, report.overdrawAfter.overdraw);
+	if (options.meshlets)
+		std::printf("  %u meshlets", report.meshletCount);
+	std::printf("\n");
+	for (size_t l = 0; l < report.lods.size(); ++l)
+		std::printf("    LOD %zu: %6u tris (%5.1f%%)  error %.5f (%.2f%% of the mesh size)\n", l + 1, report.lods[l].triangleCount,
+			100.0 * report.lods[l].triangleCount / (source.indexCount / 3), report.lods[l].error, 100.0 * report.lods[l].relativeError);
+	if (options.lods && report.lods.empty())
+		std::printf("    no LODs: nothing could be simplified within the error budget\n");
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool toV2 = true;
+	H2B::OPTIMIZE_OPTIONS options;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--to-v2") == 0)
+			toV2 = true;
+		else if (std::strcmp(argv[i], "--to-v1") == 0)
+			toV2 = false;
+		else if (std::strcmp(argv[i], "--weld") == 0)
+			options.weld = true;
+		else if (std::strcmp(argv[i], "--meshlets") == 0)
+			options.meshlets = true;
+		else if (std::strcmp(argv[i], "--vfetch") == 0)
+			options.vertexFetch = true;
+		else if (std::strcmp(argv[i], "--vcache") == 0)
+			options.vertexCache = true;
+		else if (std::strncmp(argv[i], "--lods", 6) == 0) {
+			options.lods = true;
+			if (argv[i][6] == '=')
+				options.lodCount = static_cast<unsigned>(std::atoi(argv[i] + 7));
+		}
+		else if (std::strncmp(argv[i], "--overdraw", 10) == 0) {
+			options.overdraw = true;
+			if (argv[i][10] == '=')
+				options.overdrawThreshold = static_cast<float>(std::atof(argv[i] + 11));
+		}
+		else
+			paths.push_back(argv[i]);
+	}
+	if (paths.size() != 2) {
+		std::printf("Usage: H2B_Cook [--weld] [--vcache] [--overdraw[=threshold]] [--meshlets] [--vfetch] [--lods[=count]] [--to-v2 | --to-v1] <input .h2b or folder> <output .h2b or folder>\n");
+		return 1;
+	}
+	if (!options.Enabled())
+		options.weld = options.vertexCache = options.overdraw = options.meshlets = options.vertexFetch = options.lods = true;
+	options.measureOverdraw = options.overdraw;
+
+	int failures = 0;
+	std::error_code error;
+	if (std::filesystem::is_directory(paths[0], error)) {
+		std::filesystem::create_directories(paths[1], error);
+		for (auto& file : ListH2BFiles({ paths[0] })) {
+			std::string output = (std::filesystem::path(paths[1]) / std::filesystem::path(file).filename()).string();
+			failures += CookFile(file, output, options, toV2) ? 0 : 1;
+		}
+	}
+	else
+		failures += CookFile(paths[0], paths[1], options, toV2) ? 0 : 1;
+	return failures == 0 ? 0 : 1;
+}
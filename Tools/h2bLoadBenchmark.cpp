@@ -0,0 +1,426 @@
+// Headless load benchmark: how long .h2b files and whole levels take to load on the CPU, no window or GL context needed.
+//   Files  - parse MB/s of every .h2b with Parse, ParseBuffered, MappedParser & StreamParser (64 KB chunks),
+//            warm (page cache hot) and cold (file evicted from the page cache before every run)
+//   Levels - the CPU side of Level_Objects::LoadLevel: GameLevel.txt read by GameLevelParser, names matched by AssetResolver and
+//            each unique .h2b parsed once through a cache like MeshCache (meshlets & LODs read, optional load time passes)
+//            on a ThreadPool like LoadLevel. Reports the load time warm & cold, heap allocations & bytes per load and
+//            the peak resident set size, then the warm load time with 1, 2, 4... threads up to the hardware's.
+// Usage: H2B_Load_Benchmark [--iterations=N] [--mapped | --copied] [--optimize] [--threads=N] [level folders...]
+// With no folders it loads Assets/Level1 and Assets/Level2. Cold runs need posix_fadvise (Linux), the share of each file
+// still cached after eviction is printed so a filesystem that ignores it doesn't pass for cold.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include "h2bToolsCommon.h"
+#include "../h2bStreamParser.h"
+#include "../h2bOptimize.h"
+#include "../h2bMeshlets.h"
+#include "../h2bSimplify.h"
+#include "../thread_pool.h"
+#include "../game_level_parser.h"
+#include "../asset_resolver.h"
+#if defined(_WIN32)
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// Every heap allocation of the process goes through these, so a load can be measured by sampling them around it
+static std::atomic<size_t> allocationCount{ 0 };
+static std::atomic<size_t> allocationBytes{ 0 };
+
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+//Returns the largest resident set size the process has had so far, in KB
+size_t PeakResidentKB()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize / 1024;
+	return 0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return static_cast<size_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+#else
+	return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+//Drops a file from the OS page cache so the next read has to go to the disk, returns false where that isn't possible
+bool EvictFromPageCache(const std::string& path)
+{
+#if defined(_WIN32)
+	(void)path;
+	return false;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return evicted;
+#endif
+}
+
+//Returns the share (0 - 1) of a file's pages in the page cache, -1 where it can't be measured
+double CachedFraction(const std::string& path)
+{
+#if defined(_WIN32)
+	(void)path;
+	return -1.0;
+#else
+	MappedFile file;
+	if (!file.Open(path.c_str()))
+		return -1.0;
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t pages = (file.Size() + page - 1) / page;
+	std::vector<unsigned char> resident(pages);
+	if (mincore(const_cast<char*>(file.Data()), file.Size(), resident.data()) != 0)
+		return -1.0;
+	size_t cached = 0;
+	for (unsigned char r : resident)
+		cached += r & 1;
+	return pages ? static_cast<double>(cached) / pages : 0.0;
+#endif
+}
+
+// How the benchmark reads .h2b files
+enum LOADER { LOADER_PARSE, LOADER_BUFFERED, LOADER_MAPPED, LOADER_STREAM, LOADER_COUNT };
+static const char* loaderNames[LOADER_COUNT] = { "Parse", "ParseBuffered", "MappedParser", "StreamParser" };
+
+// CPU side of a MeshResource
+struct CPU_MESH {
+	H2B::Parser parser;
+	H2B::MappedParser mapped;
+	std::vector<H2B::MESHLET> meshlets;
+	std::vector<H2B::MESHLET_RANGE> meshletRanges;
+	H2B::LOD_CHAIN lods;
+};
+
+// A loaded level: what Level_Objects keeps on the CPU
+struct CPU_LEVEL {
+	struct MODEL {
+		std::string name;
+		float world[16];
+		std::shared_ptr<CPU_MESH> mesh;
+	};
+	std::vector<MODEL> models;
+	std::unordered_map<std::string, std::shared_ptr<CPU_MESH>> meshCache;
+	size_t missing = 0;
+};
+
+//Parses one .h2b the way MeshResource::LoadFromDisk does, false if it could not be read
+bool LoadMesh(const std::string& path, LOADER loader, const H2B::OPTIMIZE_OPTIONS* optimize, CPU_MESH& mesh)
+{
+	bool mapped = loader == LOADER_MAPPED && optimize == nullptr;
+	bool loaded = false;
+	if (mapped)
+		loaded = mesh.mapped.Parse(path.c_str());
+	else if (loader == LOADER_STREAM)
+		loaded = H2B::ParseInChunks(path.c_str(), mesh.parser);
+	else if (loader == LOADER_BUFFERED)
+		loaded = mesh.parser.ParseBuffered(path.c_str());
+	else
+		loaded = mesh.parser.Parse(path.c_str());
+	if (!loaded)
+		return false;
+	if (!mapped && optimize)
+		H2B::Optimize(mesh.parser, *optimize);
+
+	const H2B::VERTEX* vertices = mapped ? mesh.mapped.vertices : mesh.parser.vertices.data();
+	const unsigned* indices = mapped ? mesh.mapped.indices : mesh.parser.indices.data();
+	unsigned vertexCount = mapped ? mesh.mapped.vertexCount : mesh.parser.vertexCount;
+	unsigned indexCount = mapped ? mesh.mapped.indexCount : mesh.parser.indexCount;
+	const std::vector<H2B::MESH>& meshes = mapped ? mesh.mapped.meshes : mesh.parser.meshes;
+	auto section = [&](unsigned type, unsigned& size) -> const char* {
+		if (mapped)
+			return mesh.mapped.FindSection(type, size);
+		const H2B::EXTRA_SECTION* found = mesh.parser.FindSection(type);
+		size = found ? static_cast<unsigned>(found->data.size()) : 0;
+		return found ? found->data.data() : nullptr;
+	};
+	unsigned size = 0;
+	const char* stored = section(H2B::SECTION_MESHLETS, size);
+	if (!H2B::ReadMeshletSection(stored, size, indexCount, mesh.meshlets))
+		H2B::BuildMeshletsInOrder(vertices, vertexCount, indices, indexCount, meshes, mesh.meshlets);
+	H2B::GetMeshletRanges(mesh.meshlets, meshes, mesh.meshletRanges);
+	if ((stored = section(H2B::SECTION_LODS, size)) != nullptr)
+		H2B::ReadLodSection(stored, size, vertexCount, static_cast<unsigned>(meshes.size()), mesh.lods);
+	return true;
+}
+
+//Loads a level like Level_Objects::LoadLevel minus logging & GPU upload, false if GameLevel.txt can't be opened
+//ThreadPool* pool - Parses the unique .h2b files side by side, nullptr parses them one after the other
+bool LoadLevelCPU(const std::string& levelFolder, LOADER loader, const H2B::OPTIMIZE_OPTIONS* optimize, ThreadPool* pool, CPU_LEVEL& level)
+{
+	GameLevelParser levelFile;
+	if (!levelFile.Parse((levelFolder + "/GameLevel.txt").c_str()))
+		return false;
+	AssetResolver resolver;
+	resolver.Scan(levelFolder + "/Models");
+	std::vector<std::string> modelFiles, pending;
+	for (auto& object : levelFile.meshes) {
+		CPU_LEVEL::MODEL model;
+		model.name = object.name;
+		std::memcpy(model.world, object.world, sizeof(model.world));
+		modelFiles.push_back(resolver.ResolvePath(object.name));
+		if (level.meshCache.emplace(modelFiles.back(), nullptr).second)
+			pending.push_back(modelFiles.back());
+		level.models.push_back(std::move(model));
+	}
+
+	std::vector<std::shared_ptr<CPU_MESH>> loaded(pending.size());
+	auto load = [&](size_t i) {
+		auto mesh = std::make_shared<CPU_MESH>();
+		if (LoadMesh(pending[i], loader, optimize, *mesh))
+			loaded[i] = std::move(mesh);
+	};
+	if (pool)
+		pool->ParallelFor(pending.size(), load);
+	else
+		for (size_t i = 0; i < pending.size(); ++i)
+			load(i);
+	for (size_t i = 0; i < pending.size(); ++i)
+		level.meshCache[pending[i]] = std::move(loaded[i]);
+
+	// file order, models whose .h2b is missing are dropped
+	std::vector<CPU_LEVEL::MODEL> models;
+	for (size_t m = 0; m < level.models.size(); ++m) {
+		level.models[m].mesh = level.meshCache[modelFiles[m]];
+		if (level.models[m].mesh)
+			models.push_back(std::move(level.models[m]));
+		else
+			++level.missing;
+	}
+	level.models = std::move(models);
+	return true;
+}
+
+//Evicts every file a level reads from the page cache, returns the largest share of a file still cached afterwards
+double EvictLevel(const std::string& levelFolder)
+{
+	std::vector<std::string> files = ListH2BFiles({ levelFolder + "/Models" });
+	files.push_back(levelFolder + "/GameLevel.txt");
+	double worst = 0;
+	for (auto& f : files) {
+		if (!EvictFromPageCache(f))
+			return -1.0;
+		worst = std::max(worst, CachedFraction(f));
+	}
+	return worst;
+}
+
+//Returns the time of one call in milliseconds
+template <typename Function>
+double TimeMs(Function function)
+{
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 20;
+	LOADER levelLoader = LOADER_MAPPED;
+	bool optimize = false;
+	unsigned threads = 0;
+	std::vector<std::string> levels;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strncmp(argv[i], "--iterations=", 13) == 0)
+			iterations = std::max(1, std::atoi(argv[i] + 13));
+		else if (std::strcmp(argv[i], "--mapped") == 0)
+			levelLoader = LOADER_MAPPED;
+		else if (std::strcmp(argv[i], "--copied") == 0)
+			levelLoader = LOADER_BUFFERED;
+		else if (std::strcmp(argv[i], "--optimize") == 0)
+			optimize = true;
+		else if (std::strncmp(argv[i], "--threads=", 10) == 0)
+			threads = static_cast<unsigned>(std::max(1, std::atoi(argv[i] + 10)));
+		else
+			levels.push_back(argv[i]);
+	}
+	if (levels.empty()) {
+		levels.push_back(H2B_ASSET_DIR "/Level1");
+		levels.push_back(H2B_ASSET_DIR "/Level2");
+	}
+	H2B::OPTIMIZE_OPTIONS passes;
+	passes.weld = passes.vertexCache = passes.overdraw = passes.meshlets = passes.vertexFetch = passes.lods = true;
+	int coldIterations = std::min(iterations, 5);
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	std::unique_ptr<ThreadPool> pool = threads > 1 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+
+	// per file parse throughput
+	std::printf("Parse throughput (MB/s, warm: %d runs, cold: %d runs with the file evicted first)\n", iterations, coldIterations);
+	std::printf("%-28s %8s", "file", "KB");
+	for (int l = 0; l < LOADER_COUNT; ++l)
+		std::printf(" %14s", loaderNames[l]);
+	std::printf("\n%-28s %8s", "", "");
+	for (int l = 0; l < LOADER_COUNT; ++l)
+		std::printf(" %6s %7s", "warm", "cold");
+	std::printf("\n");
+	std::vector<std::string> files;
+	for (auto& level : levels)
+		for (auto& f : ListH2BFiles({ level + "/Models" }))
+			files.push_back(f);
+	double totalBytes = 0, totalWarm[LOADER_COUNT] = {}, totalCold[LOADER_COUNT] = {};
+	double worstCached = 0;
+	bool canEvict = true;
+	for (auto& path : files) {
+		double bytes = static_cast<double>(std::filesystem::file_size(path));
+		totalBytes += bytes;
+		std::printf("%-28s %8.1f", std::filesystem::path(path).filename().string().c_str(), bytes / 1024.0);
+		for (int l = 0; l < LOADER_COUNT; ++l) {
+			CPU_MESH mesh;
+			auto parse = [&] {
+				if (l == LOADER_MAPPED)
+					return mesh.mapped.Parse(path.c_str());
+				if (l == LOADER_STREAM)
+					return H2B::ParseInChunks(path.c_str(), mesh.parser);
+				return l == LOADER_BUFFERED ? mesh.parser.ParseBuffered(path.c_str()) : mesh.parser.Parse(path.c_str());
+			};
+			parse();
+			double warm = 0, cold = 0;
+			for (int i = 0; i < iterations; ++i)
+				warm += TimeMs(parse);
+			for (int i = 0; i < coldIterations && canEvict; ++i) {
+				canEvict = EvictFromPageCache(path);
+				worstCached = std::max(worstCached, CachedFraction(path));
+				cold += TimeMs(parse);
+			}
+			warm /= iterations;
+			cold /= coldIterations;
+			totalWarm[l] += warm;
+			totalCold[l] += cold;
+			double mb = bytes / (1024.0 * 1024.0);
+			if (canEvict)
+				std::printf(" %6.0f %7.0f", mb / (warm / 1000.0), mb / (cold / 1000.0));
+			else
+				std::printf(" %6.0f %7s", mb / (warm / 1000.0), "n/a");
+		}
+		std::printf("\n");
+	}
+	std::printf("%-28s %8.1f", "total", totalBytes / 1024.0);
+	for (int l = 0; l < LOADER_COUNT; ++l) {
+		double mb = totalBytes / (1024.0 * 1024.0);
+		if (canEvict)
+			std::printf(" %6.0f %7.0f", mb / (totalWarm[l] / 1000.0), mb / (totalCold[l] / 1000.0));
+		else
+			std::printf(" %6.0f %7s", mb / (totalWarm[l] / 1000.0), "n/a");
+	}
+	std::printf("\n");
+	if (canEvict && worstCached > 0.5)
+		std::printf("WARNING: eviction was ignored (up to %.0f%% of a file stayed cached), the cold numbers are not cold on this system\n", worstCached * 100.0);
+	else if (canEvict)
+		std::printf("(after eviction at most %.0f%% of a file was still cached)\n", worstCached * 100.0);
+
+	// whole levels
+	std::printf("\nLevel loads (%s%s, %u thread(s)): CPU side of Level_Objects::LoadLevel, no GPU upload\n", loaderNames[levelLoader],
+		optimize ? " + load time passes" : "", threads);
+	std::printf("%-24s %7s %7s %10s %10s %12s %12s %12s\n", "level", "models", "meshes", "warm ms", "cold ms", "allocations", "alloc KB", "peak RSS KB");
+	int failures = 0;
+	for (auto& levelFolder : levels) {
+		CPU_LEVEL level;
+		if (!LoadLevelCPU(levelFolder, levelLoader, optimize ? &passes : nullptr, pool.get(), level)) {
+			std::printf("%-24s GameLevel.txt not found\n", levelFolder.c_str());
+			++failures;
+			continue;
+		}
+		size_t models = level.models.size(), meshes = 0;
+		for (auto& cached : level.meshCache)
+			meshes += cached.second != nullptr;
+		size_t missing = level.missing;
+		level = CPU_LEVEL();
+
+		double warm = 0, cold = 0;
+		size_t allocations = 0, bytes = 0;
+		for (int i = 0; i < iterations; ++i) {
+			CPU_LEVEL loaded;
+			size_t countBefore = allocationCount.load(), bytesBefore = allocationBytes.load();
+			warm += TimeMs([&] { LoadLevelCPU(levelFolder, levelLoader, optimize ? &passes : nullptr, pool.get(), loaded); });
+			allocations = allocationCount.load() - countBefore;
+			bytes = allocationBytes.load() - bytesBefore;
+		}
+		bool coldValid = true;
+		for (int i = 0; i < coldIterations && coldValid; ++i) {
+			double cached = EvictLevel(levelFolder);
+			coldValid = cached >= 0 && cached <= 0.5;
+			CPU_LEVEL loaded;
+			cold += TimeMs([&] { LoadLevelCPU(levelFolder, levelLoader, optimize ? &passes : nullptr, pool.get(), loaded); });
+		}
+		std::string name = std::filesystem::path(levelFolder).filename().string();
+		std::printf("%-24s %7zu %7zu %10.3f", name.c_str(), models, meshes, warm / iterations);
+		if (coldValid)
+			std::printf(" %10.3f", cold / coldIterations);
+		else
+			std::printf(" %10s", "n/a");
+		std::printf(" %12zu %12.1f %12zu\n", allocations, bytes / 1024.0, PeakResidentKB());
+		if (missing > 0)
+			std::printf("%-24s %zu model(s) reference a missing .h2b\n", "", missing);
+	}
+
+	// how the warm load time scales with the number of parsing threads
+	std::printf("\nWarm level load ms by thread count (speedup over 1 thread)\n%-24s", "level");
+	std::vector<unsigned> counts;
+	for (unsigned t = 1; t < threads; t *= 2)
+		counts.push_back(t);
+	counts.push_back(threads);
+	for (unsigned t : counts)
+		std::printf(" %16u", t);
+	std::printf("\n");
+	for (auto& levelFolder : levels) {
+		std::printf("%-24s", std::filesystem::path(levelFolder).filename().string().c_str());
+		double serial = 0;
+		for (unsigned t : counts) {
+			std::unique_ptr<ThreadPool> scaled = t > 1 ? std::make_unique<ThreadPool>(t - 1) : nullptr;
+			double warm = 0;
+			for (int i = 0; i < iterations; ++i) {
+				CPU_LEVEL loaded;
+				warm += TimeMs([&] { LoadLevelCPU(levelFolder, levelLoader, optimize ? &passes : nullptr, scaled.get(), loaded); });
+			}
+			warm /= iterations;
+			serial = t == 1 ? warm : serial;
+			std::printf(" %9.3f (%4.2fx)", warm, serial / warm);
+		}
+		std::printf("\n");
+	}
+	return failures == 0 ? 0 : 1;
+}
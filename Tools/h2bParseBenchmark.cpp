@@ -0,0 +1,96 @@
+// Microbenchmark comparing the ways an .h2b file can be read.
+//   Parse         - original std::ifstream path (many small reads + getline per string)
+//   ParseBuffered - whole file in one read, decoded from memory with bounds checking
+//   MappedParser  - memory mapped, vertices/indices/names used in place
+//   StreamParser  - read in 64 KB chunks, each fed to a push style StreamParser as it arrives (ParseInChunks)
+// Every file is also fed to a StreamParser in odd sized chunks to check it matches Parse.
+// Usage: H2B_Parse_Benchmark [iterations] [.h2b files or folders...]
+// With no files it runs over every .h2b in Assets/Level1/Models and Assets/Level2/Models.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include "h2bToolsCommon.h"
+#include "../h2bStreamParser.h"
+
+//Returns true if feeding the file's bytes in "chunkSize" pieces gives the same result as Parse
+bool SameWhenStreamed(const std::string& path, const H2B::Parser& reference, size_t chunkSize)
+{
+	std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+	std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	H2B::StreamParser stream;
+	for (size_t offset = 0; offset < bytes.size(); offset += chunkSize)
+		stream.Feed(bytes.data() + offset, std::min(chunkSize, bytes.size() - offset));
+	return stream.Finish() && SameResult(reference, stream.GetResult());
+}
+
+//Runs "parse" iterations times and returns the average time of one call in microseconds
+template <typename ParseFunction>
+double TimeParse(int iterations, ParseFunction parse)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		if (!parse())
+			return -1.0;
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 200;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; ++i) {
+		if (i == 1 && std::atoi(argv[i]) > 0)
+			iterations = std::atoi(argv[i]);
+		else
+			inputs.push_back(argv[i]);
+	}
+	std::vector<std::string> files = ListH2BFiles(inputs);
+	if (files.empty()) {
+		std::printf("No .h2b files found.\n");
+		return 1;
+	}
+
+	std::printf("%-48s %9s %12s %12s %12s %12s %9s\n", "file", "KB", "Parse us", "Buffered us", "Mapped us", "Stream us", "speedup");
+	double totalBytes = 0, totalParse = 0, totalBuffered = 0, totalMapped = 0, totalStream = 0;
+	int mismatches = 0;
+	for (auto& path : files) {
+		H2B::Parser streamed, buffered;
+		H2B::MappedParser mapped;
+		if (!streamed.Parse(path.c_str()) || !buffered.ParseBuffered(path.c_str())) {
+			std::printf("%-48s failed to parse\n", path.c_str());
+			++mismatches;
+			continue;
+		}
+		if (!SameResult(streamed, buffered)) {
+			std::printf("%-48s ParseBuffered result differs from Parse\n", path.c_str());
+			++mismatches;
+		}
+		for (size_t chunkSize : { 1, 7, 4096 })
+			if (!SameWhenStreamed(path, streamed, chunkSize)) {
+				std::printf("%-48s StreamParser result (%zu byte chunks) differs from Parse\n", path.c_str(), chunkSize);
+				++mismatches;
+			}
+		H2B::Parser chunked;
+		double bytes = static_cast<double>(std::filesystem::file_size(path));
+		double parseTime = TimeParse(iterations, [&] { return streamed.Parse(path.c_str()); });
+		double bufferedTime = TimeParse(iterations, [&] { return buffered.ParseBuffered(path.c_str()); });
+		double mappedTime = TimeParse(iterations, [&] { return mapped.Parse(path.c_str()); });
+		double streamTime = TimeParse(iterations, [&] { return H2B::ParseInChunks(path.c_str(), chunked); });
+		std::printf("%-48s %9.1f %12.2f %12.2f %12.2f %12.2f %8.2fx\n", std::filesystem::path(path).filename().string().c_str(),
+			bytes / 1024.0, parseTime, bufferedTime, mappedTime, streamTime, parseTime / bufferedTime);
+		totalBytes += bytes;
+		totalParse += parseTime;
+		totalBuffered += bufferedTime;
+		totalMapped += mappedTime;
+		totalStream += streamTime;
+	}
+	auto throughput = [&](double micros) { return (totalBytes / (1024.0 * 1024.0)) / (micros / 1e6); };
+	std::printf("\n%zu files, %.1f KB, %d iterations each\n", files.size(), totalBytes / 1024.0, iterations);
+	std::printf("Parse         %10.2f us total %9.1f MB/s\n", totalParse, throughput(totalParse));
+	std::printf("ParseBuffered %10.2f us total %9.1f MB/s (%.2fx)\n", totalBuffered, throughput(totalBuffered), totalParse / totalBuffered);
+	std::printf("MappedParser  %10.2f us total %9.1f MB/s (%.2fx)\n", totalMapped, throughput(totalMapped), totalParse / totalMapped);
+	std::printf("StreamParser  %10.2f us total %9.1f MB/s (%.2fx)\n", totalStream, throughput(totalStream), totalParse / totalStream);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Helpers shared by the standalone .h2b tools & benchmarks
+#ifndef _H2B_TOOLS_COMMON_H_
+#define _H2B_TOOLS_COMMON_H_
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../h2bParser.h"
+
+#ifndef H2B_ASSET_DIR
+#define H2B_ASSET_DIR "../Assets"
+#endif
+
+//Returns true if both parsers produced identical data
+inline bool SameResult(const H2B::Parser& a, const H2B::Parser& b)
+{
+	if (a.vertexCount != b.vertexCount || a.indexCount != b.indexCount ||
+		a.materialCount != b.materialCount || a.meshCount != b.meshCount)
+		return false;
+	if (std::memcmp(a.vertices.data(), b.vertices.data(), sizeof(H2B::VERTEX) * a.vertexCount) != 0 ||
+		std::memcmp(a.indices.data(), b.indices.data(), sizeof(unsigned) * a.indexCount) != 0 ||
+		std::memcmp(a.batches.data(), b.batches.data(), sizeof(H2B::BATCH) * a.materialCount) != 0)
+		return false;
+	auto sameString = [](const char* x, const char* y) {
+		return (x == nullptr && y == nullptr) || (x != nullptr && y != nullptr && std::strcmp(x, y) == 0);
+	};
+	for (unsigned i = 0; i < a.materialCount; ++i) {
+		if (std::memcmp(&a.materials[i].attrib, &b.materials[i].attrib, sizeof(H2B::ATTRIBUTES)) != 0)
+			return false;
+		for (int j = 0; j < 10; ++j)
+			if (!sameString(*((&a.materials[i].name) + j), *((&b.materials[i].name) + j)))
+				return false;
+	}
+	for (unsigned i = 0; i < a.meshCount; ++i)
+		if (!sameString(a.meshes[i].name, b.meshes[i].name) ||
+			a.meshes[i].materialIndex != b.meshes[i].materialIndex ||
+			std::memcmp(&a.meshes[i].drawInfo, &b.meshes[i].drawInfo, sizeof(H2B::BATCH)) != 0)
+			return false;
+	return true;
+}
+
+//Expands every folder in "inputs" into the .h2b files it contains (sorted), files are passed through
+//With no inputs the shipped Assets/Level1/Models and Assets/Level2/Models folders are used
+inline std::vector<std::string> ListH2BFiles(std::vector<std::string> inputs)
+{
+	if (inputs.empty()) {
+		inputs.push_back(H2B_ASSET_DIR "/Level1/Models");
+		inputs.push_back(H2B_ASSET_DIR "/Level2/Models");
+	}
+	std::vector<std::string> files;
+	for (auto& input : inputs) {
+		std::error_code error;
+		if (std::filesystem::is_directory(input, error)) {
+			std::vector<std::string> found;
+			for (auto& entry : std::filesystem::directory_iterator(input, error))
+				if (entry.path().extension() == ".h2b")
+					found.push_back(entry.path().string());
+			std::sort(found.begin(), found.end());
+			files.insert(files.end(), found.begin(), found.end());
+		}
+		else
+			files.push_back(input);
+	}
+	return files;
+}
+#endif
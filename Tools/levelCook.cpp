@@ -0,0 +1,106 @@
+// Offline cook step for levels: compiles GameLevel.txt into GameLevel.h2l (see h2bScene.h) next to it.
+// Object names are matched to the .h2b files of the level's Models folder by AssetResolver, so LoadLevel neither parses
+// text nor looks up files when it finds a compiled scene at least as new as the text. The written scene is read back and
+// compared with the text. Prints the blocks found, the names resolved and every name no model file was found for.
+// Usage: Level_Cook [--keep-numbers] [level folders...]
+//   --keep-numbers - don't drop Blender's ".001" duplicate numbers when matching names
+// With no folders it cooks Assets/Level1 and Assets/Level2 (each folder holds GameLevel.txt & Models/).
+#include <cstdio>
+#include <cstdlib>
+#include "h2bToolsCommon.h"
+#include "../game_level_parser.h"
+#include "../asset_resolver.h"
+#include "../h2bScene.h"
+
+//Returns true if the mapped scene holds exactly the blocks of the text file, with the model files it was written with
+bool SameScene(const H2B::MappedScene& scene, const GameLevelParser& level, const std::vector<std::string>& meshFiles)
+{
+	if (scene.entityCount != level.meshes.size() || scene.lightCount != level.lights.size() || scene.cameraCount != level.cameras.size())
+		return false;
+	auto same = [&](const H2B::SCENE_ENTITY& entity, const LEVEL_OBJECT& object) {
+		return entity.type == static_cast<unsigned>(object.type) && std::strcmp(scene.GetString(entity.name), object.name) == 0 &&
+			std::memcmp(entity.world, object.world, sizeof(entity.world)) == 0;
+	};
+	for (size_t i = 0; i < level.meshes.size(); ++i) {
+		const char* meshFile = scene.GetMeshFile(scene.entities[i]);
+		if (!same(scene.entities[i], level.meshes[i]) || meshFile == nullptr || meshFiles[i] != meshFile)
+			return false;
+	}
+	for (size_t i = 0; i < level.lights.size(); ++i)
+		if (!same(scene.lights[i], level.lights[i]))
+			return false;
+	for (size_t i = 0; i < level.cameras.size(); ++i)
+		if (!same(scene.cameras[i], level.cameras[i]))
+			return false;
+	return true;
+}
+
+//Compiles one level folder, false if it can't be read or written
+bool CookLevel(const std::string& levelFolder, bool stripNumbers)
+{
+	std::string textPath = levelFolder + "/GameLevel.txt";
+	std::string scenePath = H2B::GetScenePath(textPath.c_str());
+	GameLevelParser level;
+	if (!level.Parse(textPath.c_str())) {
+		std::printf("%s: can't be read\n", textPath.c_str());
+		return false;
+	}
+	AssetResolver resolver;
+	resolver.SetStripDuplicateNumbers(stripNumbers);
+	if (!resolver.Scan(levelFolder + "/Models"))
+		std::printf("%s: model folder not found\n", levelFolder.c_str());
+
+	// model files relative to the model folder, unresolved names keep the name LoadLevel used to guess
+	std::vector<std::string> meshFiles;
+	std::vector<const char*> unresolved;
+	for (auto& object : level.meshes) {
+		if (const std::string* file = resolver.Resolve(object.name))
+			meshFiles.push_back(*file);
+		else {
+			unresolved.push_back(object.name);
+			std::string path = resolver.ResolvePath(object.name);
+			meshFiles.push_back(path.substr(path.find_last_of('/') + 1));
+		}
+	}
+	if (!H2B::WriteScene(scenePath.c_str(), level, meshFiles)) {
+		std::printf("%s: can't be written\n", scenePath.c_str());
+		return false;
+	}
+	H2B::MappedScene scene;
+	bool verified = scene.Open(scenePath.c_str()) && SameScene(scene, level, meshFiles);
+	std::error_code error;
+	std::printf("%-24s %7zu %7zu %7zu %9zu %10zu %7u %10.1f %s\n", std::filesystem::path(levelFolder).filename().string().c_str(),
+		level.meshes.size(), level.lights.size(), level.cameras.size(), level.meshes.size() - unresolved.size(), unresolved.size(),
+		scene.meshCount, std::filesystem::file_size(scenePath, error) / 1024.0, verified ? "ok" : "READ BACK DIFFERS");
+	for (const char* name : unresolved)
+		std::printf("    no model file for %s\n", name);
+	for (size_t line : level.malformedLines)
+		std::printf("    skipped malformed block on line %zu\n", line);
+	return verified;
+}
+
+int main(int argc, char** argv)
+{
+	bool stripNumbers = true;
+	std::vector<std::string> levels;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--keep-numbers") == 0)
+			stripNumbers = false;
+		else if (std::strncmp(argv[i], "--", 2) == 0) {
+			std::printf("Usage: Level_Cook [--keep-numbers] [level folders...]\n");
+			return 1;
+		}
+		else
+			levels.push_back(argv[i]);
+	}
+	if (levels.empty()) {
+		levels.push_back(H2B_ASSET_DIR "/Level1");
+		levels.push_back(H2B_ASSET_DIR "/Level2");
+	}
+
+	std::printf("%-24s %7s %7s %7s %9s %10s %7s %10s\n", "level", "meshes", "lights", "cameras", "resolved", "unresolved", "files", "KB");
+	int failures = 0;
+	for (auto& level : levels)
+		failures += CookLevel(level, stripNumbers) ? 0 : 1;
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+// Benchmark of the GameLevel.txt readers.
+//   Line by line - the old LoadLevel path: a 1024 byte line buffer, strcmp per line, std::string name & model file
+//                  temporaries and sscanf(linebuffer + 13, "%f, %f, %f, %f") per matrix row
+//   GameLevelParser - one pass over the mapped file with std::from_chars
+//   Compiled scene  - the same level written by H2B::WriteScene (Tools/levelCook), mapped & walked by H2B::MappedScene
+// Runs over the shipped levels and over synthetic levels of 1k, 10k & 100k blocks written like the Blender exporter does
+// (\r\n lines, the same column layout, a mix of MESH, LIGHT & CAMERA blocks), and checks both readers find the same meshes.
+// A copy of each synthetic level with uneven whitespace checks GameLevelParser still reads every block.
+// Usage: Level_Parse_Benchmark [iterations] [GameLevel.txt files...]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include "h2bToolsCommon.h"
+#include "../game_level_parser.h"
+#include "../h2bScene.h"
+
+// What the old reader keeps of a MESH block
+struct LINE_MESH {
+	std::string name;
+	std::string modelFile;
+	float world[16];
+};
+
+//Reads a level the way LoadLevel did before GameLevelParser (minus logging), false if the file can't be opened
+bool ReadLineByLine(const std::string& path, std::vector<LINE_MESH>& meshes)
+{
+	meshes.clear();
+	std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open())
+		return false;
+	char linebuffer[1024];
+	// GFile::ReadLine on a text mode file, \r\n ends a line
+	auto readLine = [&] {
+		if (!file.getline(linebuffer, 1024))
+			return false;
+		size_t length = std::strlen(linebuffer);
+		if (length > 0 && linebuffer[length - 1] == '\r')
+			linebuffer[length - 1] = '\0';
+		return true;
+	};
+	while (readLine()) {
+		if (std::strcmp(linebuffer, "MESH") != 0)
+			continue;
+		LINE_MESH mesh;
+		readLine();
+		mesh.name = linebuffer;
+		std::string modelFile = linebuffer;
+		modelFile = modelFile.substr(0, modelFile.find_last_of("."));
+		modelFile += ".h2b";
+		mesh.modelFile = modelFile;
+		for (int i = 0; i < 4; ++i) {
+			readLine();
+			std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
+				&mesh.world[0 + i * 4], &mesh.world[1 + i * 4], &mesh.world[2 + i * 4], &mesh.world[3 + i * 4]);
+		}
+		meshes.push_back(std::move(mesh));
+	}
+	return true;
+}
+
+//Returns true if both readers found the same meshes in the same order
+bool SameMeshes(const std::vector<LINE_MESH>& lines, const GameLevelParser& parser)
+{
+	if (lines.size() != parser.meshes.size())
+		return false;
+	for (size_t i = 0; i < lines.size(); ++i)
+		if (lines[i].name != parser.meshes[i].name || std::memcmp(lines[i].world, parser.meshes[i].world, sizeof(lines[i].world)) != 0)
+			return false;
+	return true;
+}
+
+//Writes a level of "blocks" blocks laid out like the exporter's output, or with uneven whitespace when "uneven" is set
+void WriteSyntheticLevel(const std::string& path, size_t blocks, bool uneven)
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> value(-50.0f, 50.0f);
+	std::string text = "# Game Level Exporter v1.0\r\n";
+	static const char* names[] = { "Wall_Cube", "Floor_Tile", "Statue_Fox_Cylinder", "Crate", "Torch" };
+	char row[160];
+	for (size_t b = 0; b < blocks; ++b) {
+		size_t kind = b % 50;
+		text += kind == 0 ? "CAMERA" : kind < 5 ? "LIGHT" : "MESH";
+		text += uneven ? " \n" : "\r\n";
+		std::snprintf(row, sizeof(row), "%s.%03zu", names[b % 5], b % 1000);
+		text += row;
+		text += uneven ? "\t\r\n\r\n" : "\r\n";
+		for (int r = 0; r < 4; ++r) {
+			float v[4] = { value(random), value(random), value(random), r == 3 ? 1.0f : 0.0f };
+			if (uneven)
+				std::snprintf(row, sizeof(row), "%s(%.4f,%.4f ,\t%.4f,   %.4f)%s", r == 0 ? "<Matrix 4x4 " : "  ", v[0], v[1], v[2], v[3],
+					r == 3 ? ">\n" : r == 1 ? " " : "\n");
+			else
+				std::snprintf(row, sizeof(row), "%s(%7.4f, %7.4f, %7.4f, %6.4f)%s", r == 0 ? "<Matrix 4x4 " : "            ", v[0], v[1], v[2], v[3],
+					r == 3 ? ">\r\n" : "\r\n");
+			text += row;
+		}
+	}
+	std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+//Runs "read" iterations times and returns the average time of one call in milliseconds
+template <typename ReadFunction>
+double TimeRead(int iterations, ReadFunction read)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		read();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 20;
+	std::vector<std::string> levels;
+	for (int i = 1; i < argc; ++i) {
+		if (i == 1 && std::atoi(argv[i]) > 0)
+			iterations = std::atoi(argv[i]);
+		else
+			levels.push_back(argv[i]);
+	}
+	std::vector<std::string> synthetic;
+	if (levels.empty()) {
+		levels.push_back(H2B_ASSET_DIR "/Level1/GameLevel.txt");
+		levels.push_back(H2B_ASSET_DIR "/Level2/GameLevel.txt");
+		std::filesystem::path folder = std::filesystem::temp_directory_path();
+		for (size_t blocks : { 1000, 10000, 100000 }) {
+			std::string path = (folder / ("SyntheticLevel" + std::to_string(blocks) + ".txt")).string();
+			WriteSyntheticLevel(path, blocks, false);
+			levels.push_back(path);
+			synthetic.push_back(path);
+		}
+	}
+
+	std::printf("%-32s %8s %8s %8s %8s %14s %14s %8s %14s %8s\n", "level", "KB", "meshes", "lights", "cameras", "line by line", "parser ms", "speedup",
+		"scene ms", "speedup");
+	int mismatches = 0;
+	for (auto& path : levels) {
+		std::vector<LINE_MESH> lines;
+		GameLevelParser parser;
+		if (!ReadLineByLine(path, lines) || !parser.Parse(path.c_str())) {
+			std::printf("%-32s can't be read\n", path.c_str());
+			++mismatches;
+			continue;
+		}
+		if (!SameMeshes(lines, parser)) {
+			std::printf("%-32s the readers found different meshes\n", path.c_str());
+			++mismatches;
+		}
+		int runs = std::max(1, static_cast<int>(iterations * 50000 / (std::filesystem::file_size(path) + 50000)));
+		double lineTime = TimeRead(runs, [&] { ReadLineByLine(path, lines); });
+		double parserTime = TimeRead(runs, [&] { parser.Parse(path.c_str()); });
+		// compiled copy of the level (names stand in for the model files), read the way LoadLevel reads one
+		std::string scenePath = (std::filesystem::temp_directory_path() / "BenchmarkLevel.h2l").string();
+		std::vector<std::string> meshFiles;
+		for (auto& mesh : parser.meshes)
+			meshFiles.push_back(mesh.name);
+		H2B::WriteScene(scenePath.c_str(), parser, meshFiles);
+		size_t sceneMeshes = 0;
+		float checksum = 0;
+		double sceneTime = TimeRead(runs, [&] {
+			H2B::MappedScene scene;
+			if (!scene.Open(scenePath.c_str()))
+				return;
+			sceneMeshes = scene.entityCount;
+			for (unsigned i = 0; i < scene.entityCount; ++i)
+				checksum += scene.entities[i].world[12] + static_cast<float>(*scene.GetString(scene.entities[i].name)) +
+					static_cast<float>(*scene.GetMeshFile(scene.entities[i]));
+		});
+		std::filesystem::remove(scenePath);
+		if (sceneMeshes != parser.meshes.size()) {
+			std::printf("%-32s the compiled scene lost meshes\n", path.c_str());
+			++mismatches;
+		}
+		double kb = std::filesystem::file_size(path) / 1024.0;
+		std::filesystem::path name = std::filesystem::path(path).parent_path().filename() / std::filesystem::path(path).filename();
+		std::printf("%-32s %8.1f %8zu %8zu %8zu %6.3f (%4.0f MB/s) %6.3f (%4.0f MB/s) %7.2fx %14.3f %7.2fx\n", name.string().c_str(),
+			kb, parser.meshes.size(), parser.lights.size(), parser.cameras.size(),
+			lineTime, kb / 1024.0 / (lineTime / 1000.0), parserTime, kb / 1024.0 / (parserTime / 1000.0), lineTime / parserTime,
+			sceneTime, parserTime / sceneTime);
+	}
+
+	// the same levels with uneven whitespace, only GameLevelParser is meant to read these
+	for (auto& path : synthetic) {
+		std::string uneven = path.substr(0, path.size() - 4) + "Uneven.txt";
+		size_t blocks = std::strtoul(std::filesystem::path(path).stem().string().c_str() + std::strlen("SyntheticLevel"), nullptr, 10);
+		WriteSyntheticLevel(uneven, blocks, true);
+		GameLevelParser parser, reference;
+		parser.Parse(uneven.c_str());
+		reference.Parse(path.c_str());
+		bool same = parser.meshes.size() + parser.lights.size() + parser.cameras.size() == blocks && parser.malformedLines.empty() &&
+			parser.meshes.size() == reference.meshes.size();
+		for (size_t i = 0; same && i < parser.meshes.size(); ++i)
+			same = std::strcmp(parser.meshes[i].name, reference.meshes[i].name) == 0 &&
+				std::memcmp(parser.meshes[i].world, reference.meshes[i].world, sizeof(parser.meshes[i].world)) == 0;
+		std::printf("%-32s %s\n", std::filesystem::path(uneven).filename().string().c_str(), same ? "read the same as the exporter layout" : "read differently");
+		mismatches += same ? 0 : 1;
+		std::filesystem::remove(uneven);
+		std::filesystem::remove(path);
+	}
+	return mismatches == 0 ? 0 : 1;
+}
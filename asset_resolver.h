@@ -0,0 +1,114 @@
+// Finds the asset file of a GameLevel object name without probing the disk per object.
+// The folder is listed once into a hash index; names are then matched against it with Blender's naming noise removed:
+//   "Wall_Cube.012"           -> "Wall_Cube" (duplicate number)  -> "Wall"       (object type suffix) -> Wall.h2b
+//   "Statue_Fox_Cylinder.036" -> "Statue_Fox_Cylinder"           -> "Statue_Fox"                     -> Statue_Fox.h2b
+//   "Platform_TopLeft"        -> Platform_TopLeft.h2b (names that already match are used as they are)
+// Matching ignores case, like the file systems the levels are made on.
+#ifndef _ASSET_RESOLVER_H_
+#define _ASSET_RESOLVER_H_
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AssetResolver {
+	std::string folder;
+	std::string extension = ".h2b";
+	// lower case file name without extension -> file name as it is on disk
+	std::unordered_map<std::string, std::string> files;
+	// normalization rules, tried in order until a name matches
+	bool stripDuplicateNumbers = true;
+	std::vector<std::string> objectSuffixes = { "_Cube", "_Cylinder", "_Sphere", "_Plane", "_Cone", "_Torus" };
+
+	static std::string Key(const char* name, size_t length) {
+		std::string key(name, length);
+		for (char& c : key)
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		return key;
+	}
+
+	// Returns the indexed file for the first "length" chars of a name, nullptr if there is none
+	const std::string* Find(const char* name, size_t length) const {
+		auto found = files.find(Key(name, length));
+		return found != files.end() ? &found->second : nullptr;
+	}
+
+public:
+	//Chooses whether Blender's ".001" style duplicate numbers are dropped from names (on by default)
+	inline void SetStripDuplicateNumbers(bool enable) {
+		stripDuplicateNumbers = enable;
+	}
+
+	//Chooses the object type suffixes dropped from names ("_Cube", "_Cylinder"... by default)
+	//const std::vector<std::string>& suffixes - Tried in order, matched ignoring case, empty turns the rule off
+	inline void SetObjectSuffixes(const std::vector<std::string>& suffixes) {
+		objectSuffixes = suffixes;
+	}
+
+	//Lists a folder once, every file with the extension becomes resolvable
+	//Returns false if the folder can't be listed (nothing resolves then)
+	//const std::string& assetFolder - Folder of the asset files
+	//const char* fileExtension - Extension of the asset files, with the dot
+	bool Scan(const std::string& assetFolder, const char* fileExtension = ".h2b") {
+		folder = assetFolder;
+		extension = fileExtension;
+		files.clear();
+		std::error_code error;
+		std::filesystem::directory_iterator it(folder, error), end;
+		if (error)
+			return false;
+		std::string lowerExtension = Key(extension.c_str(), extension.size());
+		for (; it != end; it.increment(error)) {
+			if (error)
+				return false;
+			std::string name = it->path().filename().string();
+			if (name.size() <= extension.size() || Key(name.c_str() + name.size() - extension.size(), extension.size()) != lowerExtension)
+				continue;
+			files.emplace(Key(name.c_str(), name.size() - extension.size()), name);
+		}
+		return true;
+	}
+
+	//Returns the file name (in the scanned folder) an object name refers to, nullptr if no rule finds one
+	//const char* objectName - Name as exported ("Wall_Cube.012")
+	const std::string* Resolve(const char* objectName) const {
+		size_t length = std::strlen(objectName);
+		if (const std::string* found = Find(objectName, length))
+			return found;
+		if (stripDuplicateNumbers) {
+			// ".NNN" at the end
+			size_t digits = length;
+			while (digits > 0 && std::isdigit(static_cast<unsigned char>(objectName[digits - 1])))
+				--digits;
+			if (digits < length && digits > 0 && objectName[digits - 1] == '.') {
+				length = digits - 1;
+				if (const std::string* found = Find(objectName, length))
+					return found;
+			}
+		}
+		for (auto& suffix : objectSuffixes)
+			if (length > suffix.size() && Key(objectName + length - suffix.size(), suffix.size()) == Key(suffix.c_str(), suffix.size()))
+				if (const std::string* found = Find(objectName, length - suffix.size()))
+					return found;
+		return nullptr;
+	}
+
+	//Returns the path of the file an object name refers to
+	//When no rule finds one it falls back to the name up to its last '.' plus the extension, which won't open
+	//const char* objectName - Name as exported ("Wall_Cube.012")
+	std::string ResolvePath(const char* objectName) const {
+		if (const std::string* found = Resolve(objectName))
+			return folder + "/" + *found;
+		const char* dot = std::strrchr(objectName, '.');
+		size_t length = dot ? static_cast<size_t>(dot - objectName) : std::strlen(objectName);
+		return folder + "/" + std::string(objectName, length) + extension;
+	}
+
+	//Returns the number of files found by the last Scan
+	inline size_t Size() const {
+		return files.size();
+	}
+};
+#endif
@@ -0,0 +1,255 @@
+// Asynchronous drop-in for GW::SYSTEM::GLog (Create, Log, LogCategorized, EnableConsoleLogging, EnableVerboseLogging, Flush).
+// Callers copy their message into a fixed size record of a lock-free ring buffer (bounded multi producer queue, one
+// sequence number per slot) and return; a background thread formats the records GLog's way and writes them to the file
+// (and the console when mirrored). The handle is copied around like GLog, every copy writes to the same file.
+// Categories can be filtered at compile time (ASYNC_LOG_VERBOSITY) and at run time (SetVerbosity); Write<category>(format, ...)
+// formats straight into the record with snprintf, so a filtered out call never builds a string.
+#ifndef _ASYNC_LOG_H_
+#define _ASYNC_LOG_H_
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Most verbose category compiled in, calls to Write with a higher one compile to nothing
+#ifndef ASYNC_LOG_VERBOSITY
+#define ASYNC_LOG_VERBOSITY 4
+#endif
+
+// Categories in order of verbosity (GLog's category strings map onto these)
+enum LOG_CATEGORY { LOG_ERROR, LOG_WARNING, LOG_EVENT, LOG_MESSAGE, LOG_INFO, LOG_NONE };
+
+class AsyncLog {
+	// One message, copied in by the caller & written out by the background thread
+	struct RECORD {
+		std::time_t time;
+		unsigned thread;
+		unsigned char category; // LOG_CATEGORY, LOG_NONE for Log()
+		char text[240]; // longer messages are cut
+	};
+	struct SLOT {
+		std::atomic<size_t> sequence;
+		RECORD record;
+	};
+	struct SHARED {
+		std::vector<SLOT> slots;
+		size_t mask = 0;
+		// next slot to fill (producers) & to write (background thread)
+		alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+		alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+		std::atomic<int> verbosity{ ASYNC_LOG_VERBOSITY };
+		std::atomic<bool> console{ false };
+		std::atomic<bool> verbose{ true };
+		std::atomic<bool> running{ true };
+		// records a caller waited on because the buffer was full
+		std::atomic<size_t> stalls{ 0 };
+		std::FILE* file = nullptr;
+		std::thread writer;
+		// date of the last record written, reformatted when the second changes
+		std::time_t dateTime = 0;
+		char date[32] = {};
+
+		~SHARED() {
+			running = false;
+			if (writer.joinable())
+				writer.join();
+			if (file)
+				std::fclose(file);
+		}
+
+		// Returns false if the buffer is full
+		bool TryPush(unsigned char category, const char* text, size_t length) {
+			size_t pos = enqueuePos.load(std::memory_order_relaxed);
+			SLOT* slot;
+			for (;;) {
+				slot = &slots[pos & mask];
+				size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+				if (difference == 0) {
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (difference < 0)
+					return false;
+				else
+					pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+			RECORD& record = slot->record;
+			record.time = std::time(nullptr);
+			record.thread = ThreadId();
+			record.category = category;
+			length = length < sizeof(record.text) - 1 ? length : sizeof(record.text) - 1;
+			std::memcpy(record.text, text, length);
+			record.text[length] = '\0';
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Queues a message, waiting on the background thread if the buffer is full (nothing is dropped)
+		void Push(unsigned char category, const char* text, size_t length) {
+			if (TryPush(category, text, length))
+				return;
+			++stalls;
+			while (!TryPush(category, text, length))
+				std::this_thread::yield();
+		}
+
+		// Writes out every queued record, returns false if there was none
+		bool Drain() {
+			size_t pos = dequeuePos.load(std::memory_order_relaxed);
+			size_t start = pos;
+			static const char* names[] = { "ERROR", "WARNING", "EVENT", "MESSAGE", "INFO" };
+			char line[sizeof(RECORD::text) + 96];
+			for (;; ++pos) {
+				SLOT& slot = slots[pos & mask];
+				if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+					break;
+				const RECORD& record = slot.record;
+				if (record.time != dateTime) {
+					dateTime = record.time;
+					std::strftime(date, sizeof(date), "%a %b %d %H:%M:%S %Y", std::localtime(&dateTime));
+				}
+				int length;
+				if (!verbose)
+					length = record.category == LOG_NONE ? std::snprintf(line, sizeof(line), "%s\n", record.text) :
+						std::snprintf(line, sizeof(line), "[%s]\t%s\n", names[record.category], record.text);
+				else if (record.category == LOG_NONE)
+					length = std::snprintf(line, sizeof(line), "[%s] ThreadID[%u]\t%s\n", date, record.thread, record.text);
+				else
+					length = std::snprintf(line, sizeof(line), "[%s] ThreadID[%u]\t[%s]\t%s\n", date, record.thread, names[record.category], record.text);
+				slot.sequence.store(pos + mask + 1, std::memory_order_release);
+				length = length < static_cast<int>(sizeof(line)) ? length : static_cast<int>(sizeof(line)) - 1;
+				if (file)
+					std::fwrite(line, 1, length, file);
+				if (console)
+					std::fwrite(line, 1, length, stdout);
+			}
+			dequeuePos.store(pos, std::memory_order_release);
+			if (pos == start)
+				return false;
+			if (file)
+				std::fflush(file);
+			return true;
+		}
+
+		// Background thread: writes while there are records, naps when there are none
+		void Run() {
+			while (running.load(std::memory_order_relaxed))
+				if (!Drain())
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			Drain();
+		}
+
+		static unsigned ThreadId() {
+			thread_local unsigned id = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000);
+			return id;
+		}
+	};
+	std::shared_ptr<SHARED> shared;
+
+	static LOG_CATEGORY Category(const char* name) {
+		static const char* names[] = { "ERROR", "WARNING", "EVENT", "MESSAGE", "INFO" };
+		for (int c = LOG_ERROR; c < LOG_NONE; ++c)
+			if (std::strcmp(name, names[c]) == 0)
+				return static_cast<LOG_CATEGORY>(c);
+		return LOG_MESSAGE;
+	}
+
+public:
+	//Opens (appends to) a log file and starts the thread writing it
+	//Returns false if the file can't be opened
+	//const char* fileName - Path of the log file
+	//size_t capacity - Records the ring buffer holds, rounded up to a power of 2
+	bool Create(const char* fileName, size_t capacity = 4096) {
+		std::FILE* file = std::fopen(fileName, "a");
+		if (file == nullptr)
+			return false;
+		auto created = std::make_shared<SHARED>();
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		created->slots = std::vector<SLOT>(size);
+		for (size_t i = 0; i < size; ++i)
+			created->slots[i].sequence.store(i, std::memory_order_relaxed);
+		created->mask = size - 1;
+		created->file = file;
+		SHARED* raw = created.get();
+		created->writer = std::thread([raw] { raw->Run(); });
+		shared = std::move(created);
+		return true;
+	}
+
+	//Mirrors everything written to the console
+	inline void EnableConsoleLogging(bool enable) {
+		if (shared)
+			shared->console = enable;
+	}
+
+	//Chooses whether lines carry the date & thread like GLog's, or only the category
+	inline void EnableVerboseLogging(bool enable) {
+		if (shared)
+			shared->verbose = enable;
+	}
+
+	//Drops every category more verbose than a level from here on (ASYNC_LOG_VERBOSITY already removed those above it)
+	//LOG_CATEGORY mostVerbose - LOG_ERROR keeps errors only, LOG_INFO keeps everything
+	inline void SetVerbosity(LOG_CATEGORY mostVerbose) {
+		if (shared)
+			shared->verbosity = mostVerbose;
+	}
+
+	//Returns true if messages of a category are written, check it before building a costly message
+	inline bool IsEnabled(LOG_CATEGORY category) const {
+		return shared && category <= ASYNC_LOG_VERBOSITY && category <= shared->verbosity.load(std::memory_order_relaxed);
+	}
+
+	//Queues a message without a category
+	bool Log(const char* message) {
+		if (!shared)
+			return false;
+		shared->Push(LOG_NONE, message, std::strlen(message));
+		return true;
+	}
+
+	//Queues a message under one of GLog's categories ("ERROR", "WARNING", "EVENT", "MESSAGE", "INFO")
+	bool LogCategorized(const char* category, const char* message) {
+		LOG_CATEGORY c = Category(category);
+		if (!IsEnabled(c))
+			return false;
+		shared->Push(static_cast<unsigned char>(c), message, std::strlen(message));
+		return true;
+	}
+
+	//Formats a message straight into the ring buffer (printf style), compiled out above ASYNC_LOG_VERBOSITY
+	template <LOG_CATEGORY category, typename... Args>
+	void Write(const char* format, Args... args) {
+		if constexpr (category <= ASYNC_LOG_VERBOSITY) {
+			if (!IsEnabled(category))
+				return;
+			char text[sizeof(RECORD::text)];
+			int length = std::snprintf(text, sizeof(text), format, args...);
+			if (length > 0)
+				shared->Push(static_cast<unsigned char>(category), text, static_cast<size_t>(length));
+		}
+	}
+
+	//Waits until everything queued so far is in the file
+	void Flush() {
+		if (!shared)
+			return;
+		size_t target = shared->enqueuePos.load(std::memory_order_acquire);
+		while (shared->dequeuePos.load(std::memory_order_acquire) < target)
+			std::this_thread::yield();
+	}
+
+	//Returns how many messages had to wait for room in the ring buffer
+	inline size_t GetStallCount() const {
+		return shared ? shared->stalls.load() : 0;
+	}
+};
+#endif
@@ -0,0 +1,112 @@
+// CPU culling of meshlets (H2B::MESHLET) & level of detail selection before their draws are issued.
+// Everything is tested in model space: the frustum comes from world * view * projection and the camera is moved
+// into the model with the inverse world matrix, so scaled and rotated instances need no per meshlet transforms.
+#ifndef _CLUSTER_CULLING_H_
+#define _CLUSTER_CULLING_H_
+#include <cmath>
+#include "h2bMeshlets.h"
+
+// View frustum as 6 inward facing planes (xyz normal, w distance)
+struct FRUSTUM {
+	float planes[6][4];
+};
+
+// Everything needed to cull one model's meshlets
+struct CULL_VIEW {
+	FRUSTUM frustum; // model space
+	float camera[3]; // model space
+	bool cullFrustum; // false draws meshlets outside the frustum too
+	bool cullBackfaces; // false when the world matrix mirrors (front faces flip) or cone culling is off
+	float lodErrorPerDistance; // geometric error allowed per unit of distance to the camera, 0 always draws full detail
+};
+
+//Returns how much geometric error per unit of distance stays under a pixel limit on screen
+//const float* projection - Row major perspective projection (element 5 is cot(fov / 2))
+//float viewportHeight - Height of the viewport in pixels
+//float pixelError - Largest on screen error allowed, 0 disables level of detail selection
+inline float GetLodErrorPerDistance(const float* projection, float viewportHeight, float pixelError)
+{
+	float pixelsPerUnit = projection[5] * viewportHeight * 0.5f; // at distance 1
+	return (pixelError > 0 && pixelsPerUnit > 0) ? pixelError / pixelsPerUnit : 0;
+}
+
+//Multiplies two row major 4x4 matrices, out = a * b (row vectors: p * a * b)
+inline void MultiplyMatrix4(const float* a, const float* b, float* out)
+{
+	float result[16];
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			result[r * 4 + c] = a[r * 4 + 0] * b[0 * 4 + c] + a[r * 4 + 1] * b[1 * 4 + c] +
+				a[r * 4 + 2] * b[2 * 4 + c] + a[r * 4 + 3] * b[3 * 4 + c];
+	for (int i = 0; i < 16; ++i)
+		out[i] = result[i];
+}
+
+//Extracts the frustum planes of a row-vector (p * M) OpenGL clip matrix, in the space M maps from
+//const float* matrix - 16 floats, row major
+inline FRUSTUM ExtractFrustum(const float* matrix)
+{
+	FRUSTUM frustum;
+	for (int p = 0; p < 6; ++p) {
+		int axis = p >> 1;
+		float sign = (p & 1) ? -1.0f : 1.0f;
+		// left/right, bottom/top, near/far: w +- x, w +- y, w +- z >= 0
+		for (int k = 0; k < 4; ++k)
+			frustum.planes[p][k] = matrix[k * 4 + 3] + sign * matrix[k * 4 + axis];
+		float length = std::sqrt(frustum.planes[p][0] * frustum.planes[p][0] + frustum.planes[p][1] * frustum.planes[p][1] +
+			frustum.planes[p][2] * frustum.planes[p][2]);
+		if (length > 0)
+			for (int k = 0; k < 4; ++k)
+				frustum.planes[p][k] /= length;
+	}
+	return frustum;
+}
+
+//Moves a world space point into the space of an affine row major world matrix
+//Returns the determinant of the matrix's 3x3 part (<= 0: mirrored or degenerate, out is left untouched when 0)
+inline float InverseTransformPoint(const float* world, const float* point, float* out)
+{
+	const float* m = world;
+	float c00 = m[5] * m[10] - m[6] * m[9], c01 = m[6] * m[8] - m[4] * m[10], c02 = m[4] * m[9] - m[5] * m[8];
+	float determinant = m[0] * c00 + m[1] * c01 + m[2] * c02;
+	if (determinant == 0)
+		return 0;
+	float inverse = 1.0f / determinant;
+	// p = local * M3 + t  ->  local = (p - t) * inverse(M3)
+	float d[3] = { point[0] - m[12], point[1] - m[13], point[2] - m[14] };
+	float i[9] = {
+		c00 * inverse, (m[2] * m[9] - m[1] * m[10]) * inverse, (m[1] * m[6] - m[2] * m[5]) * inverse,
+		c01 * inverse, (m[0] * m[10] - m[2] * m[8]) * inverse, (m[2] * m[4] - m[0] * m[6]) * inverse,
+		c02 * inverse, (m[1] * m[8] - m[0] * m[9]) * inverse, (m[0] * m[5] - m[1] * m[4]) * inverse };
+	for (int k = 0; k < 3; ++k)
+		out[k] = d[0] * i[0 * 3 + k] + d[1] * i[1 * 3 + k] + d[2] * i[2 * 3 + k];
+	return determinant;
+}
+
+//Returns false if a sphere lies completely outside the frustum
+inline bool SphereInFrustum(const FRUSTUM& frustum, const float center[3], float radius)
+{
+	for (int p = 0; p < 6; ++p)
+		if (frustum.planes[p][0] * center[0] + frustum.planes[p][1] * center[1] + frustum.planes[p][2] * center[2] +
+			frustum.planes[p][3] < -radius)
+			return false;
+	return true;
+}
+
+//Returns true if every triangle of a meshlet faces away from the camera (counter clockwise front faces)
+inline bool MeshletBackfacing(const H2B::MESHLET& meshlet, const float camera[3])
+{
+	float toCenter[3] = { meshlet.center[0] - camera[0], meshlet.center[1] - camera[1], meshlet.center[2] - camera[2] };
+	float distance = std::sqrt(toCenter[0] * toCenter[0] + toCenter[1] * toCenter[1] + toCenter[2] * toCenter[2]);
+	return toCenter[0] * meshlet.coneAxis[0] + toCenter[1] * meshlet.coneAxis[1] + toCenter[2] * meshlet.coneAxis[2] >=
+		meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+//Returns true if a meshlet may be visible from the view
+inline bool MeshletVisible(const H2B::MESHLET& meshlet, const CULL_VIEW& view)
+{
+	if (view.cullFrustum && !SphereInFrustum(view.frustum, meshlet.center, meshlet.radius))
+		return false;
+	return !(view.cullBackfaces && MeshletBackfacing(meshlet, view.camera));
+}
+#endif
@@ -0,0 +1,184 @@
+// Reads the GameLevel.txt files written by the Blender level exporter in one pass over the memory mapped file.
+// Every MESH, LIGHT and CAMERA block becomes a LEVEL_OBJECT (name + 4x4 world matrix):
+//   MESH
+//   Platform_TopLeft
+//   <Matrix 4x4 ( 3.0000,  0.0000, 0.0000, 0.0000)
+//               ( 0.0000,  1.0000, 0.0000, 0.0000)
+//               ...4 rows in all...>
+// Whitespace is free (spaces, tabs, \r\n or \n, rows split over lines or not) and numbers go through std::from_chars,
+// so nothing is copied into line buffers or temporary strings. Unknown lines are skipped, malformed blocks too.
+#ifndef _GAME_LEVEL_PARSER_H_
+#define _GAME_LEVEL_PARSER_H_
+#include <charconv>
+#include <cstring>
+#include <vector>
+#include "h2bParser.h"
+#include "mapped_file.h"
+
+// What a block of the level file describes
+enum LEVEL_OBJECT_TYPE { LEVEL_MESH, LEVEL_LIGHT, LEVEL_CAMERA };
+
+// One block of the level file
+struct LEVEL_OBJECT {
+	LEVEL_OBJECT_TYPE type;
+	const char* name; // as exported ("Wall_Cube.012"), owned by the GameLevelParser
+	float world[16]; // row major, the last row holds the position
+	size_t line; // line of the block's keyword (1 based), for messages
+};
+
+class GameLevelParser {
+	// names of all objects, stored once
+	H2B::StringArena names;
+
+	static bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	// Moves "at" past spaces, tabs & line breaks (counting lines), plus commas when "commas" is set
+	static void SkipSpace(const char*& at, const char* end, size_t& line, bool commas = false) {
+		for (; at < end && (IsSpace(*at) || (commas && *at == ',')); ++at)
+			if (*at == '\n')
+				++line;
+	}
+
+	// Returns the line starting at "at" without surrounding whitespace in [first, last), moves "at" to the next line
+	static void NextLine(const char*& at, const char* end, size_t& line, const char*& first, const char*& last) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(at, '\n', static_cast<size_t>(end - at)));
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		first = at;
+		last = lineEnd;
+		while (first < last && IsSpace(*first))
+			++first;
+		while (last > first && IsSpace(last[-1]))
+			--last;
+		at = lineEnd < end ? lineEnd + 1 : end;
+		if (lineEnd < end)
+			++line;
+	}
+
+	// Reads "<Matrix 4x4 (a, b, c, d) (e, f, g, h) ... >" into world, false if it isn't one
+	static bool ReadMatrix(const char*& at, const char* end, size_t& line, float* world) {
+		SkipSpace(at, end, line);
+		static const char tag[] = "<Matrix 4x4";
+		if (static_cast<size_t>(end - at) < sizeof(tag) - 1 || std::memcmp(at, tag, sizeof(tag) - 1) != 0)
+			return false;
+		at += sizeof(tag) - 1;
+		for (int row = 0; row < 4; ++row) {
+			SkipSpace(at, end, line);
+			if (at == end || *at != '(')
+				return false;
+			++at;
+			for (int column = 0; column < 4; ++column) {
+				SkipSpace(at, end, line, column > 0);
+				if (at < end && *at == '+')
+					++at;
+				auto result = std::from_chars(at, end, world[row * 4 + column]);
+				if (result.ec != std::errc())
+					return false;
+				at = result.ptr;
+			}
+			SkipSpace(at, end, line);
+			if (at == end || *at != ')')
+				return false;
+			++at;
+		}
+		// stay on the last row's line, the caller skips the rest of it
+		while (at < end && (*at == ' ' || *at == '\t'))
+			++at;
+		if (at < end && *at == '>')
+			++at;
+		return true;
+	}
+
+public:
+	// MESH, LIGHT & CAMERA blocks, each in file order
+	std::vector<LEVEL_OBJECT> meshes;
+	std::vector<LEVEL_OBJECT> lights;
+	std::vector<LEVEL_OBJECT> cameras;
+	// keyword lines of blocks that were skipped because their name or matrix was missing or malformed
+	std::vector<size_t> malformedLines;
+
+	//Reads a GameLevel.txt, false if it can't be opened (or is empty)
+	//const char* gameLevelPath - The file written by the level exporter
+	bool Parse(const char* gameLevelPath) {
+		Clear();
+		MappedFile file;
+		if (!file.Open(gameLevelPath))
+			return false;
+		ParseText(file.Data(), file.Size());
+		return true;
+	}
+
+	//Reads level text already in memory, previous results are cleared
+	//const char* text - The text, need not be '\0' terminated
+	//size_t size - Bytes of text
+	void ParseText(const char* text, size_t size) {
+		Clear();
+		const char* at = text;
+		const char* end = text + size;
+		size_t line = 1;
+		while (at < end) {
+			size_t keywordLine = line;
+			const char* first;
+			const char* last;
+			NextLine(at, end, line, first, last);
+			size_t length = static_cast<size_t>(last - first);
+			LEVEL_OBJECT object;
+			std::vector<LEVEL_OBJECT>* list;
+			if (length == 4 && std::memcmp(first, "MESH", 4) == 0) {
+				object.type = LEVEL_MESH;
+				list = &meshes;
+			}
+			else if (length == 5 && std::memcmp(first, "LIGHT", 5) == 0) {
+				object.type = LEVEL_LIGHT;
+				list = &lights;
+			}
+			else if (length == 6 && std::memcmp(first, "CAMERA", 6) == 0) {
+				object.type = LEVEL_CAMERA;
+				list = &cameras;
+			}
+			else
+				continue; // comments, blank lines & anything newer exporters add
+			object.line = keywordLine;
+
+			// the name is the next line with anything on it
+			do
+				NextLine(at, end, line, first, last);
+			while (first == last && at < end);
+			const char* matrix = at;
+			size_t matrixLine = line;
+			if (first == last || !ReadMatrix(matrix, end, matrixLine, object.world)) {
+				// carry on right after the name, the next keyword may still be fine
+				malformedLines.push_back(keywordLine);
+				continue;
+			}
+			object.name = names.Intern(first, static_cast<size_t>(last - first));
+			list->push_back(object);
+			// the rest of the matrix's last line
+			at = matrix;
+			line = matrixLine;
+			NextLine(at, end, line, first, last);
+		}
+	}
+
+	//Adds a block that was read some other way (a compiled scene), the name is copied
+	void AddObject(LEVEL_OBJECT_TYPE type, const char* name, const float* world, size_t line = 0) {
+		LEVEL_OBJECT object;
+		object.type = type;
+		object.name = names.Intern(name);
+		std::memcpy(object.world, world, sizeof(object.world));
+		object.line = line;
+		(type == LEVEL_MESH ? meshes : type == LEVEL_LIGHT ? lights : cameras).push_back(object);
+	}
+
+	//Frees everything read, names handed out become invalid
+	void Clear() {
+		meshes.clear();
+		lights.clear();
+		cameras.clear();
+		malformedLines.clear();
+		names.Clear();
+	}
+};
+#endif
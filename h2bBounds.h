@@ -0,0 +1,136 @@
+#ifndef _H2BBOUNDS_H_
+#define _H2BBOUNDS_H_
+// Bounding volumes of .h2b vertex data: an axis aligned box and a sphere around it, per file and per H2B::MESH.
+// The kernels walk positions with a byte stride so they work straight on H2B::VERTEX arrays (mapped or copied);
+// each position is read as 4 floats, so 16 bytes must be readable at every position (pos is followed by uvw in a VERTEX).
+#include <cmath>
+#include <cstddef>
+#include "h2bSimd.h"
+#if H2B_SIMD_SSE2
+#include <xmmintrin.h>
+#endif
+
+namespace H2B {
+
+	// Box & sphere around a set of points, all zero when there were none
+	struct BOUNDS {
+		float min[3];
+		float max[3];
+		float center[3];
+		float radius;
+	};
+
+	// Finds the box & sphere (centered on the box) of count positions (SIMD min/max, 4 wide sphere radius)
+	// const void* firstPosition - The first position (3 floats)
+	// size_t stride - Bytes from one position to the next
+	// const unsigned* indices - Optional, only the positions these indices point at are used (out of range ones are skipped)
+	// size_t count - Number of positions, or of indices when indices is given
+	// size_t positionCount - Number of positions behind firstPosition (bounds check for indices)
+	inline BOUNDS ComputeBounds(const void* firstPosition, size_t stride, const unsigned* indices, size_t count, size_t positionCount)
+	{
+		const char* base = static_cast<const char*>(firstPosition);
+		auto at = [&](size_t i) { return reinterpret_cast<const float*>(base + i * stride); };
+		// walks the used positions, skipping indices that point outside the array
+		size_t cursor = 0;
+		auto next = [&](const float*& position) {
+			while (cursor < count) {
+				size_t i = indices ? indices[cursor] : cursor;
+				++cursor;
+				if (i < positionCount) {
+					position = at(i);
+					return true;
+				}
+			}
+			return false;
+		};
+
+		BOUNDS bounds = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, 0 };
+		const float* p = nullptr;
+		if (!next(p))
+			return bounds;
+		float minimum[4] = { p[0], p[1], p[2], 0 }, maximum[4] = { p[0], p[1], p[2], 0 };
+#if H2B_SIMD_SSE2
+		// lanes are x, y, z and whatever follows the position (ignored)
+		__m128 low = _mm_loadu_ps(p), high = low;
+		while (next(p)) {
+			__m128 value = _mm_loadu_ps(p);
+			low = _mm_min_ps(low, value);
+			high = _mm_max_ps(high, value);
+		}
+		_mm_storeu_ps(minimum, low);
+		_mm_storeu_ps(maximum, high);
+#else
+		while (next(p))
+			for (int k = 0; k < 3; ++k) {
+				minimum[k] = p[k] < minimum[k] ? p[k] : minimum[k];
+				maximum[k] = p[k] > maximum[k] ? p[k] : maximum[k];
+			}
+#endif
+		for (int k = 0; k < 3; ++k) {
+			bounds.min[k] = minimum[k];
+			bounds.max[k] = maximum[k];
+			bounds.center[k] = (minimum[k] + maximum[k]) * 0.5f;
+		}
+
+		// radius: the farthest position from the center
+		float radiusSq = 0;
+		const float* c = bounds.center;
+		auto farther = [&](const float* t) {
+			float d = (t[0] - c[0]) * (t[0] - c[0]) + (t[1] - c[1]) * (t[1] - c[1]) + (t[2] - c[2]) * (t[2] - c[2]);
+			radiusSq = d > radiusSq ? d : radiusSq;
+		};
+		cursor = 0;
+		const float* group[4];
+		int grouped = 0;
+#if H2B_SIMD_SSE2
+		// 4 positions at a time, transposed to x, y & z rows
+		const __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]);
+		__m128 farthest = _mm_setzero_ps();
+		while (next(group[grouped])) {
+			if (++grouped < 4)
+				continue;
+			grouped = 0;
+			__m128 r0 = _mm_loadu_ps(group[0]), r1 = _mm_loadu_ps(group[1]), r2 = _mm_loadu_ps(group[2]), r3 = _mm_loadu_ps(group[3]);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			__m128 dx = _mm_sub_ps(r0, cx), dy = _mm_sub_ps(r1, cy), dz = _mm_sub_ps(r2, cz);
+			farthest = _mm_max_ps(farthest, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, farthest);
+		for (int k = 0; k < 4; ++k)
+			radiusSq = lanes[k] > radiusSq ? lanes[k] : radiusSq;
+#else
+		while (next(group[0]))
+			farther(group[0]);
+#endif
+		for (int k = 0; k < grouped; ++k)
+			farther(group[k]);
+		bounds.radius = std::sqrt(radiusSq);
+		return bounds;
+	}
+
+	// Moves model space bounds into world space with an affine row major (row vector) matrix
+	// The box is the box around the transformed box, the sphere's radius grows with the largest axis scale
+	inline BOUNDS TransformBounds(const BOUNDS& local, const float* world)
+	{
+		BOUNDS result;
+		for (int j = 0; j < 3; ++j) {
+			result.min[j] = result.max[j] = world[12 + j];
+			result.center[j] = world[12 + j];
+			for (int i = 0; i < 3; ++i) {
+				float a = world[i * 4 + j] * local.min[i], b = world[i * 4 + j] * local.max[i];
+				result.min[j] += a < b ? a : b;
+				result.max[j] += a < b ? b : a;
+				result.center[j] += world[i * 4 + j] * local.center[i];
+			}
+		}
+		float scaleSq = 0;
+		for (int i = 0; i < 3; ++i) {
+			float s = world[i * 4] * world[i * 4] + world[i * 4 + 1] * world[i * 4 + 1] + world[i * 4 + 2] * world[i * 4 + 2];
+			scaleSq = s > scaleSq ? s : scaleSq;
+		}
+		result.radius = local.radius * std::sqrt(scaleSq);
+		return result;
+	}
+}
+#endif
@@ -0,0 +1,303 @@
+#ifndef _H2BCOMPACTVERTEX_H_
+#define _H2BCOMPACTVERTEX_H_
+// Compact 16 byte vertex layout for H2B::VERTEX data (36 bytes as floats).
+//   pos - x,y,z as 16 bit unorm relative to the mesh's bounding box (+2 bytes padding)
+//   nrm - octahedral encoded normal as 2 x 16 bit snorm
+//   uv  - u,v as 16 bit unorm relative to the mesh's uv range (uvw.z is dropped, no shader uses it)
+// Encode/Decode have SSE2 kernels that work on 4 vertices at a time, with a scalar path for the rest.
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "h2bParser.h"
+#include "h2bSimd.h"
+
+namespace H2B {
+
+#pragma pack(push,1)
+	struct COMPACT_VERTEX {
+		uint16_t pos[4]; // x, y, z, unused
+		int16_t nrm[2];
+		uint16_t uv[2];
+	};
+#pragma pack(pop)
+	static_assert(sizeof(COMPACT_VERTEX) == 16, "compact vertex must stay 16 bytes");
+
+	// Maps quantized values back to the original range: value = offset + (q / 65535) * scale
+	// Stored as vec4s so it can be copied straight into a uniform buffer.
+	struct QUANTIZATION {
+		float positionOffset[4];
+		float positionScale[4];
+		float uvTransform[4]; // u offset, v offset, u scale, v scale
+	};
+
+	// Computes the position & uv range of a vertex array (SIMD min/max)
+	inline QUANTIZATION ComputeQuantization(const VERTEX* vertices, unsigned vertexCount)
+	{
+		float minimum[5] = { 0, 0, 0, 0, 0 }, maximum[5] = { 0, 0, 0, 0, 0 }; // x, y, z, u, v
+		if (vertexCount > 0) {
+			const VECTOR& p = vertices[0].pos;
+			const VECTOR& t = vertices[0].uvw;
+			float first[5] = { p.x, p.y, p.z, t.x, t.y };
+			for (int i = 0; i < 5; ++i)
+				minimum[i] = maximum[i] = first[i];
+		}
+		unsigned i = 0;
+#if H2B_SIMD_SSE2
+		// lanes are pos.x, pos.y, pos.z, uvw.x read straight from the packed vertex
+		__m128 low = _mm_setr_ps(minimum[0], minimum[1], minimum[2], minimum[3]);
+		__m128 high = _mm_setr_ps(maximum[0], maximum[1], maximum[2], maximum[3]);
+		float lowV = minimum[4], highV = maximum[4];
+		for (; i < vertexCount; ++i) {
+			__m128 value = _mm_loadu_ps(&vertices[i].pos.x);
+			low = _mm_min_ps(low, value);
+			high = _mm_max_ps(high, value);
+			lowV = vertices[i].uvw.y < lowV ? vertices[i].uvw.y : lowV;
+			highV = vertices[i].uvw.y > highV ? vertices[i].uvw.y : highV;
+		}
+		_mm_storeu_ps(minimum, low);
+		_mm_storeu_ps(maximum, high);
+		minimum[4] = lowV;
+		maximum[4] = highV;
+#endif
+		for (; i < vertexCount; ++i) {
+			const VECTOR& p = vertices[i].pos;
+			const VECTOR& t = vertices[i].uvw;
+			float value[5] = { p.x, p.y, p.z, t.x, t.y };
+			for (int j = 0; j < 5; ++j) {
+				minimum[j] = value[j] < minimum[j] ? value[j] : minimum[j];
+				maximum[j] = value[j] > maximum[j] ? value[j] : maximum[j];
+			}
+		}
+		QUANTIZATION q;
+		for (int j = 0; j < 3; ++j) {
+			q.positionOffset[j] = minimum[j];
+			q.positionScale[j] = maximum[j] - minimum[j];
+		}
+		q.positionOffset[3] = 0.0f;
+		q.positionScale[3] = 1.0f;
+		q.uvTransform[0] = minimum[3];
+		q.uvTransform[1] = minimum[4];
+		q.uvTransform[2] = maximum[3] - minimum[3];
+		q.uvTransform[3] = maximum[4] - minimum[4];
+		return q;
+	}
+
+	// Scalar reference versions of the kernels, also used for the vertices the SIMD loops leave over
+	// They do the same operations in the same order (round to nearest even) so both paths give identical bits.
+	inline uint16_t QuantizeUnorm16(float value, float offset, float inverseScale) {
+		float normalized = (value - offset) * inverseScale;
+		normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+		return static_cast<uint16_t>(std::nearbyint(normalized * 65535.0f));
+	}
+	inline int16_t QuantizeSnorm16(float value) {
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<int16_t>(std::nearbyint(value * 32767.0f));
+	}
+	inline void EncodeCompactVertex(const VERTEX& in, COMPACT_VERTEX& out, const float* inverseScale, const QUANTIZATION& q) {
+		out.pos[0] = QuantizeUnorm16(in.pos.x, q.positionOffset[0], inverseScale[0]);
+		out.pos[1] = QuantizeUnorm16(in.pos.y, q.positionOffset[1], inverseScale[1]);
+		out.pos[2] = QuantizeUnorm16(in.pos.z, q.positionOffset[2], inverseScale[2]);
+		out.pos[3] = 0;
+		// octahedral projection: divide by the L1 norm, fold the lower hemisphere over the diagonals
+		float length = std::fabs(in.nrm.x) + std::fabs(in.nrm.y) + std::fabs(in.nrm.z);
+		float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+		float x = in.nrm.x * inverse;
+		float y = in.nrm.y * inverse;
+		if (in.nrm.z < 0.0f) {
+			float foldX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float foldY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = foldX;
+			y = foldY;
+		}
+		out.nrm[0] = QuantizeSnorm16(x);
+		out.nrm[1] = QuantizeSnorm16(y);
+		out.uv[0] = QuantizeUnorm16(in.uvw.x, q.uvTransform[0], inverseScale[3]);
+		out.uv[1] = QuantizeUnorm16(in.uvw.y, q.uvTransform[1], inverseScale[4]);
+	}
+	inline void DecodeCompactVertex(const COMPACT_VERTEX& in, VERTEX& out, const QUANTIZATION& q) {
+		const float unorm = 1.0f / 65535.0f;
+		out.pos.x = q.positionOffset[0] + in.pos[0] * (q.positionScale[0] * unorm);
+		out.pos.y = q.positionOffset[1] + in.pos[1] * (q.positionScale[1] * unorm);
+		out.pos.z = q.positionOffset[2] + in.pos[2] * (q.positionScale[2] * unorm);
+		out.uvw.x = q.uvTransform[0] + in.uv[0] * (q.uvTransform[2] * unorm);
+		out.uvw.y = q.uvTransform[1] + in.uv[1] * (q.uvTransform[3] * unorm);
+		out.uvw.z = 0.0f;
+		float x = in.nrm[0] * (1.0f / 32767.0f), y = in.nrm[1] * (1.0f / 32767.0f);
+		x = x < -1.0f ? -1.0f : x;
+		y = y < -1.0f ? -1.0f : y;
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+		float t = z < 0.0f ? -z : 0.0f;
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+		out.nrm.x = x * inverseLength;
+		out.nrm.y = y * inverseLength;
+		out.nrm.z = z * inverseLength;
+	}
+
+	// Returns 1 / scale for x, y, z, u, v (0 for a flat axis so everything maps to the offset)
+	inline void InverseScales(const QUANTIZATION& q, float* inverseScale) {
+		const float scales[5] = { q.positionScale[0], q.positionScale[1], q.positionScale[2], q.uvTransform[2], q.uvTransform[3] };
+		for (int i = 0; i < 5; ++i)
+			inverseScale[i] = scales[i] > 0.0f ? 1.0f / scales[i] : 0.0f;
+	}
+
+#if H2B_SIMD_SSE2
+	// SSE2 helpers, lanes always hold the same field of 4 different vertices
+	inline __m128 ClampUnit(__m128 value, __m128 low) {
+		return _mm_min_ps(_mm_max_ps(value, low), _mm_set1_ps(1.0f));
+	}
+	// Flips the sign of "value" where "sign" is negative (copysign style, -0 counts as positive like the scalar path)
+	inline __m128 SignNotZero(__m128 sign) {
+		__m128 negative = _mm_cmplt_ps(sign, _mm_setzero_ps());
+		return _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-1.0f)), _mm_andnot_ps(negative, _mm_set1_ps(1.0f)));
+	}
+	inline __m128 Abs(__m128 value) {
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+	}
+#endif
+
+	// Encodes vertexCount vertices into the compact layout
+	// const VERTEX* vertices - Source vertices
+	// unsigned vertexCount - Number of vertices
+	// COMPACT_VERTEX* out - Destination, room for vertexCount vertices
+	// const QUANTIZATION& q - Ranges from ComputeQuantization
+	inline void EncodeCompactVertices(const VERTEX* vertices, unsigned vertexCount, COMPACT_VERTEX* out, const QUANTIZATION& q)
+	{
+		float inverseScale[5];
+		InverseScales(q, inverseScale);
+		unsigned i = 0;
+#if H2B_SIMD_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 unorm = _mm_set1_ps(65535.0f);
+		const __m128 snorm = _mm_set1_ps(32767.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 offsetX = _mm_set1_ps(q.positionOffset[0]), offsetY = _mm_set1_ps(q.positionOffset[1]);
+		const __m128 offsetZ = _mm_set1_ps(q.positionOffset[2]), offsetU = _mm_set1_ps(q.uvTransform[0]);
+		const __m128 offsetV = _mm_set1_ps(q.uvTransform[1]);
+		const __m128 scaleX = _mm_set1_ps(inverseScale[0]), scaleY = _mm_set1_ps(inverseScale[1]);
+		const __m128 scaleZ = _mm_set1_ps(inverseScale[2]), scaleU = _mm_set1_ps(inverseScale[3]);
+		const __m128 scaleV = _mm_set1_ps(inverseScale[4]);
+		const __m128i low16 = _mm_set1_epi32(0xFFFF);
+		// every unaligned 16 byte load below stays inside its 36 byte vertex
+		for (; i + 4 <= vertexCount; i += 4) {
+			const VERTEX* v = vertices + i;
+			// pos.x pos.y pos.z uvw.x -> X Y Z U
+			__m128 X = _mm_loadu_ps(&v[0].pos.x), Y = _mm_loadu_ps(&v[1].pos.x);
+			__m128 Z = _mm_loadu_ps(&v[2].pos.x), U = _mm_loadu_ps(&v[3].pos.x);
+			_MM_TRANSPOSE4_PS(X, Y, Z, U);
+			// uvw.y uvw.z nrm.x nrm.y -> V _ NX NY
+			__m128 V = _mm_loadu_ps(&v[0].uvw.y), W = _mm_loadu_ps(&v[1].uvw.y);
+			__m128 NX = _mm_loadu_ps(&v[2].uvw.y), NY = _mm_loadu_ps(&v[3].uvw.y);
+			_MM_TRANSPOSE4_PS(V, W, NX, NY);
+			// nrm.z
+			__m128 NZ = _mm_setr_ps(v[0].nrm.z, v[1].nrm.z, v[2].nrm.z, v[3].nrm.z);
+
+			// unorm16 position & uv
+			__m128i QX = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(_mm_mul_ps(_mm_sub_ps(X, offsetX), scaleX), zero), unorm));
+			__m128i QY = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(_mm_mul_ps(_mm_sub_ps(Y, offsetY), scaleY), zero), unorm));
+			__m128i QZ = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(_mm_mul_ps(_mm_sub_ps(Z, offsetZ), scaleZ), zero), unorm));
+			__m128i QU = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(_mm_mul_ps(_mm_sub_ps(U, offsetU), scaleU), zero), unorm));
+			__m128i QV = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(_mm_mul_ps(_mm_sub_ps(V, offsetV), scaleV), zero), unorm));
+
+			// octahedral normal
+			__m128 length = _mm_add_ps(_mm_add_ps(Abs(NX), Abs(NY)), Abs(NZ));
+			__m128 valid = _mm_cmpgt_ps(length, zero);
+			__m128 inverse = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_or_ps(length, _mm_andnot_ps(valid, _mm_set1_ps(1.0f)))));
+			__m128 OX = _mm_mul_ps(NX, inverse), OY = _mm_mul_ps(NY, inverse);
+			__m128 foldX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(OY)), SignNotZero(OX));
+			__m128 foldY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(OX)), SignNotZero(OY));
+			__m128 lower = _mm_cmplt_ps(NZ, zero);
+			OX = _mm_or_ps(_mm_and_ps(lower, foldX), _mm_andnot_ps(lower, OX));
+			OY = _mm_or_ps(_mm_and_ps(lower, foldY), _mm_andnot_ps(lower, OY));
+			__m128i QNX = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(OX, minusOne), snorm));
+			__m128i QNY = _mm_cvtps_epi32(_mm_mul_ps(ClampUnit(OY, minusOne), snorm));
+
+			// pack pairs of 16 bit fields into 32 bit lanes, then transpose so each lane becomes one vertex
+			__m128i P0 = _mm_or_si128(QX, _mm_slli_epi32(QY, 16));
+			__m128i P1 = QZ;
+			__m128i P2 = _mm_or_si128(_mm_and_si128(QNX, low16), _mm_slli_epi32(QNY, 16));
+			__m128i P3 = _mm_or_si128(QU, _mm_slli_epi32(QV, 16));
+			__m128 R0 = _mm_castsi128_ps(P0), R1 = _mm_castsi128_ps(P1), R2 = _mm_castsi128_ps(P2), R3 = _mm_castsi128_ps(P3);
+			_MM_TRANSPOSE4_PS(R0, R1, R2, R3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 0), _mm_castps_si128(R0));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 1), _mm_castps_si128(R1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 2), _mm_castps_si128(R2));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 3), _mm_castps_si128(R3));
+		}
+#endif
+		for (; i < vertexCount; ++i)
+			EncodeCompactVertex(vertices[i], out[i], inverseScale, q);
+	}
+
+	// Decodes vertexCount compact vertices back to full float vertices (uvw.z becomes 0)
+	// const COMPACT_VERTEX* vertices - Source vertices
+	// unsigned vertexCount - Number of vertices
+	// VERTEX* out - Destination, room for vertexCount vertices
+	// const QUANTIZATION& q - The ranges the vertices were encoded with
+	inline void DecodeCompactVertices(const COMPACT_VERTEX* vertices, unsigned vertexCount, VERTEX* out, const QUANTIZATION& q)
+	{
+		unsigned i = 0;
+#if H2B_SIMD_SSE2
+		const __m128 unorm = _mm_set1_ps(1.0f / 65535.0f);
+		const __m128 snorm = _mm_set1_ps(1.0f / 32767.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128i low16 = _mm_set1_epi32(0xFFFF);
+		const __m128 offsetX = _mm_set1_ps(q.positionOffset[0]), offsetY = _mm_set1_ps(q.positionOffset[1]);
+		const __m128 offsetZ = _mm_set1_ps(q.positionOffset[2]), offsetU = _mm_set1_ps(q.uvTransform[0]);
+		const __m128 offsetV = _mm_set1_ps(q.uvTransform[1]);
+		const __m128 scaleX = _mm_mul_ps(_mm_set1_ps(q.positionScale[0]), unorm), scaleY = _mm_mul_ps(_mm_set1_ps(q.positionScale[1]), unorm);
+		const __m128 scaleZ = _mm_mul_ps(_mm_set1_ps(q.positionScale[2]), unorm), scaleU = _mm_mul_ps(_mm_set1_ps(q.uvTransform[2]), unorm);
+		const __m128 scaleV = _mm_mul_ps(_mm_set1_ps(q.uvTransform[3]), unorm);
+		for (; i + 4 <= vertexCount; i += 4) {
+			__m128 R0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(vertices + i + 0)));
+			__m128 R1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(vertices + i + 1)));
+			__m128 R2 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(vertices + i + 2)));
+			__m128 R3 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(vertices + i + 3)));
+			_MM_TRANSPOSE4_PS(R0, R1, R2, R3);
+			__m128i P0 = _mm_castps_si128(R0), P1 = _mm_castps_si128(R1), P2 = _mm_castps_si128(R2), P3 = _mm_castps_si128(R3);
+
+			__m128 X = _mm_add_ps(offsetX, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(P0, low16)), scaleX));
+			__m128 Y = _mm_add_ps(offsetY, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(P0, 16)), scaleY));
+			__m128 Z = _mm_add_ps(offsetZ, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(P1, low16)), scaleZ));
+			__m128 U = _mm_add_ps(offsetU, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(P3, low16)), scaleU));
+			__m128 V = _mm_add_ps(offsetV, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(P3, 16)), scaleV));
+
+			// sign extend the snorm16 halves, then unfold the octahedron
+			__m128 NX = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(P2, 16), 16)), snorm), minusOne);
+			__m128 NY = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(P2, 16)), snorm), minusOne);
+			__m128 NZ = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), Abs(NX)), Abs(NY));
+			__m128 T = _mm_max_ps(_mm_sub_ps(zero, NZ), zero);
+			NX = _mm_sub_ps(NX, _mm_mul_ps(T, SignNotZero(NX)));
+			NY = _mm_sub_ps(NY, _mm_mul_ps(T, SignNotZero(NY)));
+			__m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f),
+				_mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(NX, NX), _mm_mul_ps(NY, NY)), _mm_mul_ps(NZ, NZ))));
+			NX = _mm_mul_ps(NX, inverseLength);
+			NY = _mm_mul_ps(NY, inverseLength);
+			NZ = _mm_mul_ps(NZ, inverseLength);
+
+			// back to one vertex per row: (X Y Z U) and (V 0 NX NY), nrm.z goes in separately
+			__m128 W = zero;
+			_MM_TRANSPOSE4_PS(X, Y, Z, U);
+			_MM_TRANSPOSE4_PS(V, W, NX, NY);
+			float z[4];
+			_mm_storeu_ps(z, NZ);
+			const __m128 first[4] = { X, Y, Z, U };
+			const __m128 second[4] = { V, W, NX, NY };
+			for (int k = 0; k < 4; ++k) {
+				VERTEX& o = out[i + k];
+				float row[8];
+				_mm_storeu_ps(row, first[k]);
+				_mm_storeu_ps(row + 4, second[k]);
+				// pos.x pos.y pos.z uvw.x uvw.y uvw.z nrm.x nrm.y
+				std::memcpy(&o, row, sizeof(row));
+				o.nrm.z = z[k];
+			}
+		}
+#endif
+		for (; i < vertexCount; ++i)
+			DecodeCompactVertex(vertices[i], out[i], q);
+	}
+}
+#endif
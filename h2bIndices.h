@@ -0,0 +1,48 @@
+#ifndef _H2BINDICES_H_
+#define _H2BINDICES_H_
+// Index buffer helpers: 32 bit .h2b indices are narrowed to 16 bits whenever the mesh allows it,
+// halving index memory and index fetch bandwidth.
+#include <cstddef>
+#include <cstdint>
+#include "h2bSimd.h"
+
+namespace H2B {
+
+	// Returns true if every index of a mesh with vertexCount vertices fits in 16 bits
+	inline bool IndicesFit16Bit(unsigned vertexCount) {
+		return vertexCount <= 0x10000u;
+	}
+
+	// Copies indexCount 32 bit indices into 16 bit ones (SSE2, 8 indices per iteration)
+	// Returns false, leaving "out" partially written, if any index does not fit in 16 bits
+	// const unsigned* indices - Source indices
+	// size_t indexCount - Number of indices
+	// uint16_t* out - Destination, room for indexCount indices
+	inline bool NarrowIndices16(const unsigned* indices, size_t indexCount, uint16_t* out)
+	{
+		size_t i = 0;
+		unsigned overflow = 0;
+#if H2B_SIMD_SSE2
+		// packs_epi32 saturates signed, so bias into signed range first and undo it after packing
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		__m128i high = _mm_setzero_si128();
+		for (; i + 8 <= indexCount; i += 8) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4));
+			high = _mm_or_si128(high, _mm_or_si128(a, b));
+			__m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi16(packed, bias16));
+		}
+		// any bit above the low 16 in any lane means an index did not fit
+		high = _mm_srli_epi32(high, 16);
+		overflow = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128()))) != 0xFFFFu;
+#endif
+		for (; i < indexCount; ++i) {
+			overflow |= indices[i] >> 16;
+			out[i] = static_cast<uint16_t>(indices[i]);
+		}
+		return overflow == 0;
+	}
+}
+#endif
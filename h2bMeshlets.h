@@ -0,0 +1,392 @@
+#ifndef _H2BMESHLETS_H_
+#define _H2BMESHLETS_H_
+// Splits the H2B::MESH index ranges of a .h2b into small clusters (meshlets) with a bounding sphere and a
+// backface normal cone each, so whole clusters that are off-screen or facing away can be skipped before drawing.
+// Each cluster is a contiguous sub-range of its mesh's index range, so it can be drawn with a plain glDrawElements.
+// Grouped meshlets (cook/load time optimization) reorder triangles and are stored as a v2 SECTION_MESHLETS,
+// files without one get meshlets cut from their triangles in stored order.
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "h2bParser.h"
+
+namespace H2B {
+
+	// A cluster of at most maxVertices vertices / maxTriangles triangles of one mesh
+	struct MESHLET {
+		float center[3]; // bounding sphere (model space)
+		float radius;
+		float coneAxis[3]; // average facing of the triangles (model space, unit length)
+		float coneCutoff; // sine of the cone's half angle, 1 when the triangles face too many ways to ever be culled
+		unsigned indexOffset; // whole triangles of the index buffer
+		unsigned indexCount;
+	};
+
+	// The meshlets of one H2B::MESH (same order as the file's meshes)
+	struct MESHLET_RANGE {
+		unsigned first;
+		unsigned count;
+	};
+
+	static_assert(sizeof(MESHLET) == 40, "SECTION_MESHLETS record layout");
+
+	// Default cluster limits, small enough for tight bounds and large enough to keep draw counts low
+	static constexpr unsigned MESHLET_MAX_VERTICES = 64;
+	static constexpr unsigned MESHLET_MAX_TRIANGLES = 124;
+
+	// Computes a meshlet's bounding sphere & normal cone from its triangles
+	// MESHLET& meshlet - indexOffset & indexCount must be set, the bounds are filled in
+	inline void ComputeMeshletBounds(MESHLET& meshlet, const VERTEX* vertices, const unsigned* indices)
+	{
+		const unsigned* tri = indices + meshlet.indexOffset;
+		float minimum[3] = { vertices[tri[0]].pos.x, vertices[tri[0]].pos.y, vertices[tri[0]].pos.z };
+		float maximum[3] = { minimum[0], minimum[1], minimum[2] };
+		for (unsigned i = 0; i < meshlet.indexCount; ++i) {
+			const float* p = &vertices[tri[i]].pos.x;
+			for (int k = 0; k < 3; ++k) {
+				minimum[k] = std::min(minimum[k], p[k]);
+				maximum[k] = std::max(maximum[k], p[k]);
+			}
+		}
+		float radiusSq = 0;
+		for (int k = 0; k < 3; ++k)
+			meshlet.center[k] = (minimum[k] + maximum[k]) * 0.5f;
+		for (unsigned i = 0; i < meshlet.indexCount; ++i) {
+			const float* p = &vertices[tri[i]].pos.x;
+			float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+			radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+		}
+		meshlet.radius = std::sqrt(radiusSq);
+
+		// cone axis: average of the unit face normals, the cone must contain every one of them
+		std::vector<float> normals;
+		normals.reserve(meshlet.indexCount);
+		float axis[3] = { 0, 0, 0 };
+		for (unsigned t = 0; t + 2 < meshlet.indexCount; t += 3) {
+			const float* a = &vertices[tri[t]].pos.x;
+			const float* b = &vertices[tri[t + 1]].pos.x;
+			const float* c = &vertices[tri[t + 2]].pos.x;
+			float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length <= 0)
+				continue; // degenerate triangles are never drawn, they don't constrain the cone
+			for (int k = 0; k < 3; ++k) {
+				normals.push_back(n[k] / length);
+				axis[k] += n[k] / length;
+			}
+		}
+		float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		float minimumDot = 1.0f;
+		if (axisLength > 0)
+			for (int k = 0; k < 3; ++k)
+				axis[k] /= axisLength;
+		else
+			minimumDot = -1.0f;
+		for (size_t n = 0; n + 2 < normals.size(); n += 3)
+			minimumDot = std::min(minimumDot, normals[n] * axis[0] + normals[n + 1] * axis[1] + normals[n + 2] * axis[2]);
+		for (int k = 0; k < 3; ++k)
+			meshlet.coneAxis[k] = axis[k];
+		// a cone wider than ~84 degrees from its axis would almost never cull, don't bother testing it
+		meshlet.coneCutoff = minimumDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+
+	// Splits one index range into meshlets, scanning its triangles in their stored order (read-only data)
+	// Returns the number of meshlets appended to "meshlets"
+	// const BATCH& range - The index range to split
+	// std::vector<MESHLET>& meshlets - Receives the new meshlets
+	inline unsigned BuildMeshletsInOrder(const VERTEX* vertices, unsigned vertexCount, const unsigned* indices, const BATCH& range,
+		std::vector<MESHLET>& meshlets, unsigned maxVertices = MESHLET_MAX_VERTICES, unsigned maxTriangles = MESHLET_MAX_TRIANGLES)
+	{
+		unsigned triangleCount = range.indexCount / 3;
+		for (unsigned i = 0; i < triangleCount * 3; ++i)
+			if (indices[range.indexOffset + i] >= vertexCount)
+				return 0;
+		// "usedBy[v] == current" marks the vertices the open meshlet already references
+		std::vector<unsigned> usedBy(vertexCount, ~0u);
+		unsigned current = 0, usedVertices = 0, usedTriangles = 0, start = range.indexOffset;
+		size_t first = meshlets.size();
+		auto close = [&](unsigned end) {
+			MESHLET meshlet = {};
+			meshlet.indexOffset = start;
+			meshlet.indexCount = end - start;
+			ComputeMeshletBounds(meshlet, vertices, indices);
+			meshlets.push_back(meshlet);
+			start = end;
+			++current;
+			usedVertices = usedTriangles = 0;
+		};
+		for (unsigned t = 0; t < triangleCount; ++t) {
+			const unsigned* tri = indices + range.indexOffset + t * 3;
+			unsigned added = (usedBy[tri[0]] != current) + (usedBy[tri[1]] != current && tri[1] != tri[0]) +
+				(usedBy[tri[2]] != current && tri[2] != tri[0] && tri[2] != tri[1]);
+			if (usedTriangles > 0 && (usedVertices + added > maxVertices || usedTriangles + 1 > maxTriangles)) {
+				close(range.indexOffset + t * 3);
+				added = 1 + (tri[1] != tri[0]) + (tri[2] != tri[0] && tri[2] != tri[1]);
+			}
+			for (int k = 0; k < 3; ++k)
+				usedBy[tri[k]] = current;
+			usedVertices += added;
+			++usedTriangles;
+		}
+		if (usedTriangles > 0)
+			close(range.indexOffset + triangleCount * 3);
+		return static_cast<unsigned>(meshlets.size() - first);
+	}
+
+	// Splits one index range into meshlets grown over connected triangles that face the same way,
+	// reordering the range's triangles so every meshlet is contiguous (tight normal cones -> more backface culling)
+	// Returns the number of meshlets appended to "meshlets"
+	// unsigned* indices - The whole index buffer, the range's triangles are reordered in place
+	// const BATCH& range - The index range to split, whole triangles
+	// std::vector<MESHLET>& meshlets - Receives the new meshlets
+	// float coneLimit - Triangles facing further than this (cosine) from the meshlet's axis are never added to it
+	inline unsigned BuildMeshletsGrouped(const VERTEX* vertices, unsigned vertexCount, unsigned* indices, const BATCH& range,
+		std::vector<MESHLET>& meshlets, unsigned maxVertices = MESHLET_MAX_VERTICES, unsigned maxTriangles = MESHLET_MAX_TRIANGLES,
+		float coneLimit = 0.8f)
+	{
+		unsigned triangleCount = range.indexCount / 3;
+		unsigned* rangeIndices = indices + range.indexOffset;
+		for (unsigned i = 0; i < triangleCount * 3; ++i)
+			if (rangeIndices[i] >= vertexCount)
+				return 0;
+
+		// unit face normals (0 for degenerate triangles, which fit any meshlet) and centroids
+		std::vector<float> normals(size_t(triangleCount) * 3, 0.0f), triangleCentroids(size_t(triangleCount) * 3);
+		for (unsigned t = 0; t < triangleCount; ++t) {
+			const float* a = &vertices[rangeIndices[t * 3]].pos.x;
+			const float* b = &vertices[rangeIndices[t * 3 + 1]].pos.x;
+			const float* c = &vertices[rangeIndices[t * 3 + 2]].pos.x;
+			for (int k = 0; k < 3; ++k)
+				triangleCentroids[t * 3 + k] = (a[k] + b[k] + c[k]) / 3.0f;
+			float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length > 0)
+				for (int k = 0; k < 3; ++k)
+					normals[t * 3 + k] = n[k] / length;
+		}
+
+		// connectivity goes through positions, not vertex indices: uv & normal seams split vertices but not surfaces
+		std::vector<unsigned> corner(size_t(triangleCount) * 3), positionOf(vertexCount, ~0u);
+		unsigned positionCount = 0;
+		{
+			size_t tableSize = 16;
+			while (tableSize < size_t(triangleCount) * 6)
+				tableSize *= 2;
+			std::vector<unsigned> table(tableSize, ~0u); // vertex index of each position's first corner
+			for (unsigned i = 0; i < triangleCount * 3; ++i) {
+				unsigned v = rangeIndices[i];
+				if (positionOf[v] == ~0u) {
+					uint32_t hash = 2166136261u; // FNV-1a
+					const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertices[v].pos);
+					for (size_t b = 0; b < sizeof(VECTOR); ++b)
+						hash = (hash ^ bytes[b]) * 16777619u;
+					size_t slot = hash & (tableSize - 1);
+					while (table[slot] != ~0u && std::memcmp(&vertices[table[slot]].pos, &vertices[v].pos, sizeof(VECTOR)) != 0)
+						slot = (slot + 1) & (tableSize - 1);
+					if (table[slot] == ~0u) {
+						table[slot] = v;
+						positionOf[v] = positionCount++;
+					}
+					else
+						positionOf[v] = positionOf[table[slot]];
+				}
+				corner[i] = positionOf[v];
+			}
+		}
+		// position -> triangles adjacency
+		std::vector<unsigned> adjacencyStart(size_t(positionCount) + 1, 0);
+		for (unsigned i = 0; i < triangleCount * 3; ++i)
+			++adjacencyStart[corner[i] + 1];
+		for (unsigned p = 0; p < positionCount; ++p)
+			adjacencyStart[p + 1] += adjacencyStart[p];
+		std::vector<unsigned> adjacency(size_t(triangleCount) * 3), fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (unsigned i = 0; i < triangleCount * 3; ++i)
+			adjacency[fill[corner[i]]++] = i / 3;
+
+		std::vector<char> emitted(triangleCount, 0);
+		// usedBy counts vertices (the meshlet limit), positionUsedBy finds neighbours
+		std::vector<unsigned> usedBy(vertexCount, ~0u), positionUsedBy(positionCount, ~0u), meshletPositions, order, bounds;
+		unsigned meshletVertexCount = 0;
+		order.reserve(triangleCount);
+		unsigned current = 0, seedCursor = 0;
+		while (order.size() < triangleCount) {
+			while (emitted[seedCursor])
+				++seedCursor;
+			// the seed is the first triangle left in stored order, so meshlets follow the overdraw pass's order
+			bounds.push_back(static_cast<unsigned>(order.size()));
+			meshletPositions.clear();
+			meshletVertexCount = 0;
+			float axis[3] = { 0, 0, 0 }, meshletCentroid[3] = { 0, 0, 0 };
+			unsigned next = seedCursor, meshletTriangles = 0;
+			while (next != ~0u) {
+				emitted[next] = 1;
+				order.push_back(next);
+				++meshletTriangles;
+				for (int k = 0; k < 3; ++k) {
+					unsigned v = rangeIndices[next * 3 + k];
+					if (usedBy[v] != current) {
+						usedBy[v] = current;
+						++meshletVertexCount;
+					}
+					if (positionUsedBy[corner[next * 3 + k]] != current) {
+						positionUsedBy[corner[next * 3 + k]] = current;
+						meshletPositions.push_back(corner[next * 3 + k]);
+					}
+					axis[k] += normals[next * 3 + k];
+					meshletCentroid[k] += triangleCentroids[next * 3 + k];
+				}
+				if (meshletTriangles >= maxTriangles)
+					break;
+				float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+				float inverseLength = axisLength > 0 ? 1.0f / axisLength : 0.0f;
+
+				// best neighbour: fewest new vertices, then closest facing
+				next = ~0u;
+				float bestScore = FLT_MAX;
+				for (unsigned p : meshletPositions)
+					for (unsigned j = adjacencyStart[p]; j < adjacencyStart[p + 1]; ++j) {
+						unsigned t = adjacency[j];
+						if (emitted[t])
+							continue;
+						const unsigned* tri = rangeIndices + t * 3;
+						unsigned added = (usedBy[tri[0]] != current) + (usedBy[tri[1]] != current && tri[1] != tri[0]) +
+							(usedBy[tri[2]] != current && tri[2] != tri[0] && tri[2] != tri[1]);
+						if (meshletVertexCount + added > maxVertices)
+							continue;
+						const float* n = &normals[t * 3];
+						bool degenerate = n[0] == 0 && n[1] == 0 && n[2] == 0;
+						float facing = degenerate ? 1.0f : (n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]) * inverseLength;
+						if (facing < coneLimit)
+							continue;
+						float score = static_cast<float>(added) + (1.0f - facing);
+						if (score < bestScore) {
+							bestScore = score;
+							next = t;
+						}
+					}
+				if (next == ~0u) {
+					// nothing connected faces the right way (e.g. the front faces of separate bricks): take the closest
+					// unconnected triangle that does, so flat regions end up in one meshlet instead of many tiny ones
+					float centroid[3] = { 0, 0, 0 };
+					for (int k = 0; k < 3; ++k)
+						centroid[k] = meshletCentroid[k] / static_cast<float>(meshletTriangles);
+					float bestDistance = FLT_MAX;
+					for (unsigned t = seedCursor; t < triangleCount; ++t) {
+						if (emitted[t])
+							continue;
+						const float* n = &normals[t * 3];
+						float facing = (n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]) * inverseLength;
+						if (facing < coneLimit)
+							continue;
+						const unsigned* tri = rangeIndices + t * 3;
+						unsigned added = (usedBy[tri[0]] != current) + (usedBy[tri[1]] != current && tri[1] != tri[0]) +
+							(usedBy[tri[2]] != current && tri[2] != tri[0] && tri[2] != tri[1]);
+						if (meshletVertexCount + added > maxVertices)
+							continue;
+						float distance = 0;
+						for (int k = 0; k < 3; ++k) {
+							float d = triangleCentroids[t * 3 + k] - centroid[k];
+							distance += d * d;
+						}
+						if (distance < bestDistance) {
+							bestDistance = distance;
+							next = t;
+						}
+					}
+				}
+			}
+			++current;
+		}
+		bounds.push_back(triangleCount);
+
+		std::vector<unsigned> reordered(size_t(triangleCount) * 3);
+		for (unsigned i = 0; i < triangleCount; ++i)
+			for (int k = 0; k < 3; ++k)
+				reordered[i * 3 + k] = rangeIndices[order[i] * 3 + k];
+		std::copy(reordered.begin(), reordered.end(), rangeIndices);
+		for (size_t m = 0; m + 1 < bounds.size(); ++m) {
+			MESHLET meshlet = {};
+			meshlet.indexOffset = range.indexOffset + bounds[m] * 3;
+			meshlet.indexCount = (bounds[m + 1] - bounds[m]) * 3;
+			ComputeMeshletBounds(meshlet, vertices, indices);
+			meshlets.push_back(meshlet);
+		}
+		return static_cast<unsigned>(bounds.size() - 1);
+	}
+
+	// Finds the meshlets of every mesh (meshlets must be sorted by indexOffset, a meshlet belongs to the mesh containing it)
+	// std::vector<MESHLET_RANGE>& ranges - Receives one entry per mesh, meshes without meshlets get count 0
+	inline void GetMeshletRanges(const std::vector<MESHLET>& meshlets, const std::vector<MESH>& meshes, std::vector<MESHLET_RANGE>& ranges)
+	{
+		ranges.assign(meshes.size(), MESHLET_RANGE{ 0, 0 });
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			const BATCH& draw = meshes[i].drawInfo;
+			auto first = std::lower_bound(meshlets.begin(), meshlets.end(), draw.indexOffset,
+				[](const MESHLET& m, unsigned offset) { return m.indexOffset < offset; });
+			auto last = first;
+			while (last != meshlets.end() && last->indexOffset + last->indexCount <= draw.indexOffset + draw.indexCount)
+				++last;
+			ranges[i].first = static_cast<unsigned>(first - meshlets.begin());
+			ranges[i].count = static_cast<unsigned>(last - first);
+			// a mesh is only culled per meshlet if its meshlets cover all of it
+			unsigned covered = 0;
+			for (auto m = first; m != last; ++m)
+				covered += m->indexCount;
+			if (covered != draw.indexCount)
+				ranges[i].count = 0;
+		}
+	}
+
+	// Builds meshlets for every mesh of read-only data, in stored triangle order
+	inline void BuildMeshletsInOrder(const VERTEX* vertices, unsigned vertexCount, const unsigned* indices, unsigned indexCount,
+		const std::vector<MESH>& meshes, std::vector<MESHLET>& meshlets)
+	{
+		meshlets.clear();
+		std::vector<BATCH> draws;
+		for (auto& m : meshes)
+			if (m.drawInfo.indexOffset <= indexCount && m.drawInfo.indexCount <= indexCount - m.drawInfo.indexOffset)
+				draws.push_back(m.drawInfo);
+		std::sort(draws.begin(), draws.end(), [](const BATCH& a, const BATCH& b) { return a.indexOffset < b.indexOffset; });
+		unsigned covered = 0;
+		for (auto& d : draws)
+			if (d.indexOffset >= covered) { // overlapping meshes share the first one's meshlets
+				BuildMeshletsInOrder(vertices, vertexCount, indices, d, meshlets);
+				covered = d.indexOffset + d.indexCount;
+			}
+	}
+
+	// Packs meshlets into a SECTION_MESHLETS v2 section
+	inline EXTRA_SECTION MakeMeshletSection(const std::vector<MESHLET>& meshlets)
+	{
+		EXTRA_SECTION section{ SECTION_MESHLETS, std::vector<char>(sizeof(MESHLET) * meshlets.size()) };
+		if (!meshlets.empty())
+			std::memcpy(section.data.data(), meshlets.data(), section.data.size());
+		return section;
+	}
+
+	// Reads a SECTION_MESHLETS section, false if it is malformed or doesn't fit the index buffer
+	inline bool ReadMeshletSection(const char* data, size_t size, unsigned indexCount, std::vector<MESHLET>& meshlets)
+	{
+		meshlets.clear();
+		if (data == nullptr || size % sizeof(MESHLET) != 0)
+			return false;
+		meshlets.resize(size / sizeof(MESHLET));
+		if (!meshlets.empty())
+			std::memcpy(meshlets.data(), data, size);
+		unsigned previousEnd = 0;
+		for (auto& m : meshlets) {
+			if (m.indexOffset < previousEnd || m.indexOffset > indexCount || m.indexCount > indexCount - m.indexOffset) {
+				meshlets.clear();
+				return false;
+			}
+			previousEnd = m.indexOffset + m.indexCount;
+		}
+		return true;
+	}
+}
+#endif
@@ -0,0 +1,593 @@
+#ifndef _H2BOPTIMIZE_H_
+#define _H2BOPTIMIZE_H_
+// Mesh optimization passes for parsed .h2b data.
+// Triangle passes only reorder triangles inside the index ranges delimited by the file's BATCH and MESH
+// draw ranges and vertex passes only renumber vertices, so each H2B::MESH drawInfo (and each BATCH)
+// still covers exactly the same triangles.
+// The passes are used at load time (MeshCache) and from the offline cook step (Tools/h2bCook.cpp).
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "h2bParser.h"
+#include "h2bMeshlets.h"
+#include "h2bSimplify.h"
+
+namespace H2B {
+
+	// Returns the index ranges triangles may be reordered in: the file split at every BATCH and MESH boundary
+	// Ranges that don't hold whole triangles are left out (and therefore left untouched).
+	// const std::vector<BATCH>& batches - The file's per material batches
+	// const std::vector<MESH>& meshes - The file's meshes
+	// unsigned indexCount - Size of the index buffer the ranges refer to
+	inline std::vector<BATCH> GetIndexRanges(const std::vector<BATCH>& batches, const std::vector<MESH>& meshes, unsigned indexCount)
+	{
+		std::vector<unsigned> bounds = { 0, indexCount };
+		auto add = [&](const BATCH& b) {
+			if (b.indexOffset < indexCount) {
+				bounds.push_back(b.indexOffset);
+				bounds.push_back(std::min(indexCount, b.indexOffset + std::min(b.indexCount, indexCount - b.indexOffset)));
+			}
+		};
+		for (auto& b : batches)
+			add(b);
+		for (auto& m : meshes)
+			add(m.drawInfo);
+		std::sort(bounds.begin(), bounds.end());
+		bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+		std::vector<BATCH> ranges;
+		for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+			unsigned count = bounds[i + 1] - bounds[i];
+			if (count >= 3 && count % 3 == 0 && bounds[i] % 3 == 0)
+				ranges.push_back(BATCH{ count, bounds[i] });
+		}
+		return ranges;
+	}
+
+	// Post-transform vertex cache efficiency of an index buffer
+	struct CACHE_STATS {
+		float acmr = 0; // average cache miss ratio: vertex shader invocations per triangle (0.5 ideal, 3 worst)
+		float atvr = 0; // average transform to vertex ratio: invocations per unique vertex (1 ideal)
+	};
+
+	// Simulates a FIFO post-transform cache over the given indices
+	// const unsigned* indices - Indices to analyze
+	// size_t indexCount - Number of indices
+	// unsigned vertexCount - Number of vertices the indices refer to
+	// unsigned cacheSize - Number of entries of the simulated cache
+	inline CACHE_STATS AnalyzeVertexCache(const unsigned* indices, size_t indexCount, unsigned vertexCount, unsigned cacheSize = 16)
+	{
+		CACHE_STATS stats;
+		if (indexCount < 3)
+			return stats;
+		// a vertex is in the cache if it was last loaded less than cacheSize loads ago
+		std::vector<size_t> loadedAt(vertexCount, ~size_t(0));
+		size_t loads = 0, unique = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned v = indices[i];
+			if (v >= vertexCount)
+				continue;
+			if (loadedAt[v] == ~size_t(0))
+				++unique;
+			if (loadedAt[v] == ~size_t(0) || loads - loadedAt[v] >= cacheSize)
+				loadedAt[v] = loads++;
+		}
+		stats.acmr = static_cast<float>(loads) / static_cast<float>(indexCount / 3);
+		stats.atvr = unique ? static_cast<float>(loads) / static_cast<float>(unique) : 0.0f;
+		return stats;
+	}
+
+	// Vertex cache stats of a whole file, each range analyzed on its own cold cache (as it is drawn)
+	inline CACHE_STATS AnalyzeVertexCache(const std::vector<unsigned>& indices, const std::vector<BATCH>& ranges, unsigned vertexCount, unsigned cacheSize = 16)
+	{
+		CACHE_STATS total;
+		double loads = 0, triangles = 0, vertices = 0;
+		for (auto& r : ranges) {
+			CACHE_STATS s = AnalyzeVertexCache(indices.data() + r.indexOffset, r.indexCount, vertexCount, cacheSize);
+			double rangeTriangles = r.indexCount / 3;
+			loads += s.acmr * rangeTriangles;
+			triangles += rangeTriangles;
+			vertices += s.atvr > 0 ? (s.acmr * rangeTriangles) / s.atvr : 0;
+		}
+		total.acmr = triangles > 0 ? static_cast<float>(loads / triangles) : 0.0f;
+		total.atvr = vertices > 0 ? static_cast<float>(loads / vertices) : 0.0f;
+		return total;
+	}
+
+	// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" scoring
+	namespace Forsyth {
+		static constexpr int cacheSize = 32;
+		static constexpr int maxValence = 32; // the valence boost saturates after this many remaining triangles
+
+		inline float CacheScore(int cachePosition) {
+			if (cachePosition < 0)
+				return 0.0f;
+			if (cachePosition < 3)
+				return 0.75f; // the last triangle's vertices, don't favour any order between them
+			float s = 1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(cacheSize - 3);
+			return std::pow(s, 1.5f);
+		}
+		inline float ValenceScore(unsigned remaining) {
+			return 2.0f / std::sqrt(static_cast<float>(std::min<unsigned>(remaining, maxValence)));
+		}
+		inline float VertexScore(int cachePosition, unsigned remaining) {
+			return remaining == 0 ? -1.0f : CacheScore(cachePosition) + ValenceScore(remaining);
+		}
+	}
+
+	// Reorders the triangles of one index range for the post-transform vertex cache (Forsyth)
+	// unsigned* indices - The range's indices, rewritten in place (same triangles, same winding)
+	// size_t indexCount - Number of indices, a multiple of 3
+	// unsigned vertexCount - Number of vertices the indices refer to
+	inline void OptimizeVertexCache(unsigned* indices, size_t indexCount, unsigned vertexCount)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+		for (size_t i = 0; i < indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return; // leave broken ranges alone
+
+		// number the vertices this range uses locally so every array is sized by the range
+		std::vector<unsigned> local(vertexCount, ~0u);
+		std::vector<unsigned> corners(indexCount);
+		unsigned localCount = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			if (local[indices[i]] == ~0u)
+				local[indices[i]] = localCount++;
+			corners[i] = local[indices[i]];
+		}
+
+		// vertex -> triangles adjacency, the first "remaining[v]" entries of a vertex are its unemitted triangles
+		std::vector<unsigned> remaining(localCount, 0), adjacencyStart(localCount + 1, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+			++remaining[corners[i]];
+		for (unsigned v = 0; v < localCount; ++v)
+			adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+		std::vector<unsigned> adjacency(indexCount), fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+			for (int k = 0; k < 3; ++k)
+				adjacency[fill[corners[t * 3 + k]]++] = static_cast<unsigned>(t);
+
+		std::vector<int> cachePosition(localCount, -1);
+		std::vector<float> vertexScore(localCount), triangleScore(triangleCount, 0.0f);
+		std::vector<char> emitted(triangleCount, 0);
+		for (unsigned v = 0; v < localCount; ++v)
+			vertexScore[v] = Forsyth::VertexScore(-1, remaining[v]);
+		for (size_t t = 0; t < triangleCount; ++t)
+			for (int k = 0; k < 3; ++k)
+				triangleScore[t] += vertexScore[corners[t * 3 + k]];
+
+		std::vector<unsigned> output;
+		output.reserve(indexCount);
+		unsigned cache[Forsyth::cacheSize + 3];
+		int cacheCount = 0;
+		size_t best = 0;
+		for (size_t t = 1; t < triangleCount; ++t)
+			if (triangleScore[t] > triangleScore[best])
+				best = t;
+		size_t scanCursor = 0;
+		for (size_t done = 0; done < triangleCount; ++done) {
+			if (best == ~size_t(0)) {
+				// nothing in the cache touches an unemitted triangle: take the best of the rest
+				while (emitted[scanCursor])
+					++scanCursor;
+				best = scanCursor;
+				for (size_t t = scanCursor + 1; t < triangleCount; ++t)
+					if (!emitted[t] && triangleScore[t] > triangleScore[best])
+						best = t;
+			}
+			emitted[best] = 1;
+			const unsigned* tri = &corners[best * 3];
+			for (int k = 0; k < 3; ++k) {
+				output.push_back(indices[best * 3 + k]);
+				// drop the triangle from the vertex's live list
+				unsigned v = tri[k];
+				unsigned* list = &adjacency[adjacencyStart[v]];
+				for (unsigned j = 0; j < remaining[v]; ++j)
+					if (list[j] == best) {
+						list[j] = list[remaining[v] - 1];
+						list[remaining[v] - 1] = static_cast<unsigned>(best);
+						break;
+					}
+				--remaining[v];
+			}
+
+			// move the triangle's vertices to the front of the LRU cache
+			unsigned next[Forsyth::cacheSize + 3];
+			int nextCount = 0;
+			for (int k = 0; k < 3; ++k)
+				next[nextCount++] = tri[k];
+			for (int c = 0; c < cacheCount; ++c)
+				if (cache[c] != tri[0] && cache[c] != tri[1] && cache[c] != tri[2])
+					next[nextCount++] = cache[c];
+			for (int c = 0; c < nextCount; ++c)
+				cachePosition[next[c]] = c < Forsyth::cacheSize ? c : -1;
+			cacheCount = std::min(nextCount, Forsyth::cacheSize);
+			for (int c = 0; c < cacheCount; ++c)
+				cache[c] = next[c];
+
+			// rescore every vertex whose cache slot changed and the live triangles around them
+			for (int c = 0; c < nextCount; ++c) {
+				unsigned v = next[c];
+				float score = Forsyth::VertexScore(cachePosition[v], remaining[v]);
+				float delta = score - vertexScore[v];
+				vertexScore[v] = score;
+				const unsigned* list = &adjacency[adjacencyStart[v]];
+				for (unsigned j = 0; j < remaining[v]; ++j)
+					triangleScore[list[j]] += delta;
+			}
+
+			// the next triangle is the best one touching the cache
+			best = ~size_t(0);
+			float bestScore = -1.0f;
+			for (int c = 0; c < cacheCount; ++c) {
+				unsigned v = cache[c];
+				const unsigned* list = &adjacency[adjacencyStart[v]];
+				for (unsigned j = 0; j < remaining[v]; ++j)
+					if (triangleScore[list[j]] > bestScore) {
+						bestScore = triangleScore[list[j]];
+						best = list[j];
+					}
+			}
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Result of the CPU overdraw estimate
+	struct OVERDRAW_STATS {
+		size_t covered = 0; // pixels covered at least once
+		size_t shaded = 0; // pixels that passed the depth test (each one is a fragment shader run)
+		float overdraw = 0; // shaded / covered (1 ideal)
+	};
+
+	// Estimates overdraw without a GPU: the triangles are rasterized in index order into a small depth buffer
+	// from the 6 axis directions (mesh bounds fitted to the grid, counter clockwise front faces, back faces culled)
+	// const unsigned* indices - Indices in draw order
+	// size_t indexCount - Number of indices
+	// const VERTEX* vertices - Vertices the indices refer to
+	// unsigned vertexCount - Number of vertices
+	// int resolution - Width & height of the simulated render target
+	inline OVERDRAW_STATS AnalyzeOverdraw(const unsigned* indices, size_t indexCount, const VERTEX* vertices, unsigned vertexCount, int resolution = 256)
+	{
+		OVERDRAW_STATS stats;
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (size_t i = 0; i < indexCount; ++i) {
+			if (indices[i] >= vertexCount)
+				return stats;
+			const float* p = &vertices[indices[i]].pos.x;
+			for (int k = 0; k < 3; ++k) {
+				minimum[k] = std::min(minimum[k], p[k]);
+				maximum[k] = std::max(maximum[k], p[k]);
+			}
+		}
+		float extent = std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+		if (indexCount < 3 || extent <= 0)
+			return stats;
+		float scale = 1.0f / extent;
+
+		std::vector<float> depth(size_t(resolution) * resolution);
+		std::vector<unsigned char> covered(depth.size());
+		for (int view = 0; view < 6; ++view) {
+			int axis = view >> 1;
+			bool flip = (view & 1) != 0;
+			std::fill(depth.begin(), depth.end(), FLT_MAX);
+			std::fill(covered.begin(), covered.end(), 0);
+			for (size_t t = 0; t + 2 < indexCount; t += 3) {
+				// screen u, v & depth: looking down +axis, or down -axis with u mirrored to keep the winding meaning
+				float x[3], y[3], z[3];
+				for (int k = 0; k < 3; ++k) {
+					const float* p = &vertices[indices[t + k]].pos.x;
+					float u = (p[(axis + 1) % 3] - minimum[(axis + 1) % 3]) * scale;
+					float v = (p[(axis + 2) % 3] - minimum[(axis + 2) % 3]) * scale;
+					float w = (p[axis] - minimum[axis]) * scale;
+					x[k] = (flip ? 1.0f - u : u) * resolution;
+					y[k] = v * resolution;
+					z[k] = flip ? 1.0f - w : w;
+				}
+				float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+				if (area >= 0)
+					continue; // back facing or degenerate
+				int x0 = std::max(0, static_cast<int>(std::floor(std::min(x[0], std::min(x[1], x[2])))));
+				int x1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(x[0], std::max(x[1], x[2])))));
+				int y0 = std::max(0, static_cast<int>(std::floor(std::min(y[0], std::min(y[1], y[2])))));
+				int y1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(y[0], std::max(y[1], y[2])))));
+				float invArea = 1.0f / area;
+				for (int py = y0; py <= y1; ++py)
+					for (int px = x0; px <= x1; ++px) {
+						// barycentrics of the pixel center, all >= 0 inside a (negative area) triangle
+						float cx = px + 0.5f, cy = py + 0.5f;
+						float b0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) * invArea;
+						float b1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) * invArea;
+						float b2 = 1.0f - b0 - b1;
+						if (b0 < 0 || b1 < 0 || b2 < 0)
+							continue;
+						float d = b0 * z[0] + b1 * z[1] + b2 * z[2];
+						size_t pixel = size_t(py) * resolution + px;
+						if (d < depth[pixel]) {
+							depth[pixel] = d;
+							++stats.shaded;
+						}
+						if (!covered[pixel]) {
+							covered[pixel] = 1;
+							++stats.covered;
+						}
+					}
+			}
+		}
+		stats.overdraw = stats.covered ? static_cast<float>(stats.shaded) / static_cast<float>(stats.covered) : 0.0f;
+		return stats;
+	}
+
+	// Reorders clusters of an already vertex cache optimized range so outward facing, front most clusters draw first
+	// (Sander, Nehab & Barczak "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+	// Clusters are cut where the cache is cold anyway, and further cut wherever that costs less than "threshold".
+	// unsigned* indices - The range's indices, rewritten in place
+	// size_t indexCount - Number of indices, a multiple of 3
+	// const VERTEX* vertices - Vertices the indices refer to
+	// unsigned vertexCount - Number of vertices
+	// float threshold - Allowed ACMR growth, 1.05 allows the cache efficiency to get 5% worse
+	inline void OptimizeOverdraw(unsigned* indices, size_t indexCount, const VERTEX* vertices, unsigned vertexCount, float threshold = 1.05f)
+	{
+		const unsigned cacheSize = 16;
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+		for (size_t i = 0; i < indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return;
+
+		// FIFO cache simulation with a timestamp per vertex, bumping "time" by more than the cache size empties it
+		std::vector<size_t> loadedAt(vertexCount, 0);
+		size_t time = cacheSize + 1;
+		auto misses = [&](size_t t) {
+			unsigned count = 0;
+			for (int k = 0; k < 3; ++k) {
+				unsigned v = indices[t * 3 + k];
+				if (time - loadedAt[v] > cacheSize) {
+					loadedAt[v] = time++;
+					++count;
+				}
+			}
+			return count;
+		};
+
+		// hard boundaries: triangles that miss on all 3 vertices start with a cold cache
+		std::vector<size_t> hard;
+		for (size_t t = 0; t < triangleCount; ++t)
+			if (misses(t) == 3)
+				hard.push_back(t);
+		hard.push_back(triangleCount);
+
+		// soft boundaries: split hard clusters wherever the ACMR so far is within threshold of the whole cluster's
+		std::vector<size_t> clusters;
+		for (size_t h = 0; h + 1 < hard.size(); ++h) {
+			size_t start = hard[h], end = hard[h + 1];
+			time += cacheSize + 1;
+			size_t clusterMisses = 0;
+			for (size_t t = start; t < end; ++t)
+				clusterMisses += misses(t);
+			float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+			time += cacheSize + 1;
+			clusters.push_back(start);
+			size_t runMisses = 0, runSize = 0;
+			for (size_t t = start; t < end; ++t) {
+				runMisses += misses(t);
+				++runSize;
+				if (t + 1 < end && static_cast<float>(runMisses) / static_cast<float>(runSize) <= clusterThreshold) {
+					clusters.push_back(t + 1);
+					time += cacheSize + 1;
+					runMisses = runSize = 0;
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+		size_t clusterCount = clusters.size() - 1;
+		if (clusterCount < 2)
+			return;
+
+		// sort key: how far the cluster's area weighted centroid lies along its average normal, seen from the range centroid
+		float center[3] = { 0, 0, 0 };
+		for (size_t i = 0; i < indexCount; ++i)
+			for (int k = 0; k < 3; ++k)
+				center[k] += (&vertices[indices[i]].pos.x)[k];
+		for (int k = 0; k < 3; ++k)
+			center[k] /= static_cast<float>(indexCount);
+		std::vector<float> sortKey(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c) {
+			float centroid[3] = { 0, 0, 0 }, normal[3] = { 0, 0, 0 }, area = 0;
+			for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+				const float* a = &vertices[indices[t * 3 + 0]].pos.x;
+				const float* b = &vertices[indices[t * 3 + 1]].pos.x;
+				const float* d = &vertices[indices[t * 3 + 2]].pos.x;
+				float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+				float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				for (int k = 0; k < 3; ++k) {
+					centroid[k] += (a[k] + b[k] + d[k]) * (triangleArea / 3.0f);
+					normal[k] += n[k];
+				}
+				area += triangleArea;
+			}
+			float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			float inverseArea = area > 0 ? 1.0f / area : 0.0f, inverseLength = length > 0 ? 1.0f / length : 0.0f;
+			sortKey[c] = 0;
+			for (int k = 0; k < 3; ++k)
+				sortKey[c] += (centroid[k] * inverseArea - center[k]) * normal[k] * inverseLength;
+		}
+
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c)
+			order[c] = c;
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+		std::vector<unsigned> output;
+		output.reserve(indexCount);
+		for (size_t c : order)
+			output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Merges vertices whose pos, uvw & nrm are bit for bit identical and remaps the indices to the survivors
+	// Returns the new vertex count (vertices keep the order of their first copy)
+	// std::vector<VERTEX>& vertices - Vertices, shrunk in place
+	// std::vector<unsigned>& indices - Indices, rewritten in place (index ranges don't move)
+	inline unsigned WeldVertices(std::vector<VERTEX>& vertices, std::vector<unsigned>& indices)
+	{
+		size_t vertexCount = vertices.size();
+		if (vertexCount == 0)
+			return 0;
+		auto hash = [](const VERTEX& v) {
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&v);
+			uint32_t h = 2166136261u; // FNV-1a
+			for (size_t i = 0; i < sizeof(VERTEX); ++i)
+				h = (h ^ bytes[i]) * 16777619u;
+			return h;
+		};
+		// open addressing hash set of surviving vertex slots, at most half full
+		size_t tableSize = 16;
+		while (tableSize < vertexCount * 2)
+			tableSize *= 2;
+		std::vector<unsigned> table(tableSize, ~0u);
+		std::vector<unsigned> remap(vertexCount);
+		unsigned unique = 0;
+		for (size_t v = 0; v < vertexCount; ++v) {
+			size_t slot = hash(vertices[v]) & (tableSize - 1);
+			while (table[slot] != ~0u && std::memcmp(&vertices[table[slot]], &vertices[v], sizeof(VERTEX)) != 0)
+				slot = (slot + 1) & (tableSize - 1);
+			if (table[slot] == ~0u) {
+				// first copy, compact it down (unique <= v, so only already visited slots get overwritten)
+				vertices[unique] = vertices[v];
+				table[slot] = unique++;
+			}
+			remap[v] = table[slot];
+		}
+		vertices.resize(unique);
+		for (auto& i : indices)
+			if (i < vertexCount)
+				i = remap[i];
+		return unique;
+	}
+
+	// Reorders the vertices to the order the index buffer first uses them in, so vertex fetch walks memory linearly
+	// Vertices no index refers to are dropped. Returns the new vertex count.
+	// std::vector<VERTEX>& vertices - Vertices, reordered in place
+	// std::vector<unsigned>& indices - Indices, rewritten in place (index ranges don't move)
+	inline unsigned OptimizeVertexFetch(std::vector<VERTEX>& vertices, std::vector<unsigned>& indices)
+	{
+		size_t vertexCount = vertices.size();
+		std::vector<unsigned> remap(vertexCount, ~0u);
+		std::vector<VERTEX> ordered;
+		ordered.reserve(vertexCount);
+		for (auto& i : indices) {
+			if (i >= vertexCount)
+				continue;
+			if (remap[i] == ~0u) {
+				remap[i] = static_cast<unsigned>(ordered.size());
+				ordered.push_back(vertices[i]);
+			}
+			i = remap[i];
+		}
+		vertices.swap(ordered);
+		return static_cast<unsigned>(vertices.size());
+	}
+
+	// Which passes Optimize runs
+	struct OPTIMIZE_OPTIONS {
+		bool weld = false; // merge bit identical vertices (runs first)
+		bool vertexCache = false; // Forsyth triangle reordering per range
+		bool overdraw = false; // cluster reordering for less overdraw (runs after, and implies, vertexCache)
+		float overdrawThreshold = 1.05f; // ACMR the overdraw pass may give up, 1.05 -> 5%
+		bool measureOverdraw = false; // run AnalyzeOverdraw before & after for the report (costs a few ms per mesh)
+		bool meshlets = false; // group triangles into meshlets (after overdraw) and store them as SECTION_MESHLETS
+		float meshletConeLimit = 0.8f; // cosine, how far a triangle may face from its meshlet's axis
+		bool vertexFetch = false; // reorder vertices to first use
+		bool lods = false; // build simplified levels (runs last) and store them as SECTION_LODS
+		unsigned lodCount = 3; // levels after the full detail one, each about half the triangles
+		float lodMaxError = 0.05f; // error budget of the coarsest level, fraction of the mesh bounds
+
+		//Returns true if any pass would rewrite the data
+		inline bool Enabled() const {
+			return weld || vertexCache || overdraw || meshlets || vertexFetch || lods;
+		}
+	};
+
+	// What Optimize did, for logs and the cook tool's report
+	struct OPTIMIZE_REPORT {
+		CACHE_STATS before;
+		CACHE_STATS after;
+		OVERDRAW_STATS overdrawBefore; // only measured with OPTIMIZE_OPTIONS::measureOverdraw
+		OVERDRAW_STATS overdrawAfter;
+		unsigned verticesBefore = 0;
+		unsigned verticesAfter = 0;
+		unsigned meshletCount = 0;
+		std::vector<LOD_REPORT> lods; // one per level built
+	};
+
+	// Runs the selected passes over a parsed file, keeping every BATCH and MESH range valid
+	// Parser& parser - The parsed file, its vertices & indices are rewritten in place
+	// const OPTIMIZE_OPTIONS& options - The passes to run
+	// OPTIMIZE_REPORT* report - Optional, receives before/after statistics
+	inline void Optimize(Parser& parser, const OPTIMIZE_OPTIONS& options, OPTIMIZE_REPORT* report = nullptr)
+	{
+		std::vector<BATCH> ranges = GetIndexRanges(parser.batches, parser.meshes, parser.indexCount);
+		if (report) {
+			report->verticesBefore = parser.vertexCount;
+			report->before = AnalyzeVertexCache(parser.indices, ranges, parser.vertexCount);
+			if (options.measureOverdraw)
+				report->overdrawBefore = AnalyzeOverdraw(parser.indices.data(), parser.indexCount, parser.vertices.data(), parser.vertexCount);
+		}
+		if (options.weld)
+			parser.vertexCount = WeldVertices(parser.vertices, parser.indices);
+		if (options.vertexCache || options.overdraw)
+			for (auto& r : ranges)
+				OptimizeVertexCache(parser.indices.data() + r.indexOffset, r.indexCount, parser.vertexCount);
+		if (options.overdraw)
+			for (auto& r : ranges)
+				OptimizeOverdraw(parser.indices.data() + r.indexOffset, r.indexCount, parser.vertices.data(), parser.vertexCount, options.overdrawThreshold);
+		if (options.vertexCache || options.overdraw || options.meshlets) {
+			// stored meshlets describe the old triangle order
+			for (size_t i = 0; i < parser.extraSections.size(); ++i)
+				if (parser.extraSections[i].type == SECTION_MESHLETS)
+					parser.extraSections.erase(parser.extraSections.begin() + i--);
+		}
+		if (options.meshlets) {
+			std::vector<MESHLET> meshlets;
+			for (auto& r : ranges)
+				BuildMeshletsGrouped(parser.vertices.data(), parser.vertexCount, parser.indices.data(), r, meshlets,
+					MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, options.meshletConeLimit);
+			// keep the vertex cache order inside each meshlet
+			for (auto& m : meshlets)
+				OptimizeVertexCache(parser.indices.data() + m.indexOffset, m.indexCount, parser.vertexCount);
+			parser.extraSections.push_back(MakeMeshletSection(meshlets));
+			if (report)
+				report->meshletCount = static_cast<unsigned>(meshlets.size());
+		}
+		if (options.weld || options.vertexFetch || options.lods) {
+			// stored levels index the old vertices
+			for (size_t i = 0; i < parser.extraSections.size(); ++i)
+				if (parser.extraSections[i].type == SECTION_LODS)
+					parser.extraSections.erase(parser.extraSections.begin() + i--);
+		}
+		if (options.vertexFetch)
+			parser.vertexCount = OptimizeVertexFetch(parser.vertices, parser.indices);
+		if (options.lods) {
+			LOD_CHAIN chain;
+			if (BuildLodChain(parser.vertices.data(), parser.vertexCount, parser.indices.data(), parser.indexCount, parser.batches,
+				parser.meshes, chain, report ? &report->lods : nullptr, options.lodCount, options.lodMaxError) > 0) {
+				for (auto& d : chain.draws)
+					OptimizeVertexCache(chain.indices.data() + d.indexOffset, d.indexCount, parser.vertexCount);
+				parser.extraSections.push_back(MakeLodSection(chain, static_cast<unsigned>(parser.meshes.size())));
+			}
+		}
+		if (report) {
+			report->verticesAfter = parser.vertexCount;
+			report->after = AnalyzeVertexCache(parser.indices, ranges, parser.vertexCount);
+			if (options.measureOverdraw)
+				report->overdrawAfter = AnalyzeOverdraw(parser.indices.data(), parser.indexCount, parser.vertices.data(), parser.vertexCount);
+		}
+	}
+}
+#endif
@@ -2,7 +2,11 @@
 #define _H2BPARSER_H_
 #include <fstream>
 #include <vector>
-#include <set>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "mapped_file.h"
+#include "h2bBounds.h"
 
 namespace H2B {
 
@@ -23,7 +27,54 @@ namespace H2B {
 	struct BATCH {
 		unsigned indexCount, indexOffset;
 	};
+
+	// H2B v2 container ("H2B2")
+	// A fixed header, then a table of sections. Every section starts 16 byte aligned, so a reader can jump
+	// straight to any of them (vertex & index data can go to the GPU as is) without decoding the others.
+	// Names live in a string table and are referenced by byte offset (NO_STRING for none).
+	// Readers skip section types they don't know, so new sections can be added without a new version.
+	struct HEADER_V2 {
+		char magic[4]; // "H2B2"
+		unsigned headerSize; // bytes before the section table
+		unsigned vertexCount, indexCount, materialCount, meshCount;
+		unsigned sectionCount;
+		unsigned reserved;
+	};
+	struct SECTION_V2 {
+		unsigned type; // SECTION_TYPE
+		unsigned offset; // from the start of the file, 16 byte aligned
+		unsigned size; // in bytes
+		unsigned reserved;
+	};
+	struct MESH_V2 {
+		unsigned name; // string table offset
+		BATCH drawInfo;
+		unsigned materialIndex;
+	};
 #pragma pack(pop)
+	struct MATERIAL_V2 {
+		ATTRIBUTES attrib;
+		unsigned names[10]; // string table offsets of name, map_Kd ... bump
+	};
+	enum SECTION_TYPE : unsigned {
+		SECTION_VERTICES = 1, // VERTEX[vertexCount]
+		SECTION_INDICES = 2, // unsigned[indexCount]
+		SECTION_MATERIALS = 3, // MATERIAL_V2[materialCount]
+		SECTION_BATCHES = 4, // BATCH[materialCount]
+		SECTION_MESHES = 5, // MESH_V2[meshCount]
+		SECTION_STRINGS = 6, // '\0' terminated strings
+		SECTION_MESHLETS = 7, // MESHLET[] (h2bMeshlets.h), optional
+		SECTION_LODS = 8, // LOD_HEADER, LOD_INFO[], BATCH[], unsigned[] (h2bSimplify.h), optional
+	};
+	static constexpr unsigned NO_STRING = 0xFFFFFFFFu;
+	static constexpr unsigned SECTION_ALIGNMENT = 16;
+	static_assert(sizeof(HEADER_V2) == 32 && sizeof(SECTION_V2) == 16, "H2B v2 header layout");
+	static_assert(sizeof(MATERIAL_V2) == 120 && sizeof(MESH_V2) == 16, "H2B v2 record layout");
+	// An optional v2 section (meshlets, LODs...) stored after the standard ones
+	struct EXTRA_SECTION {
+		unsigned type;
+		std::vector<char> data;
+	};
 	struct MATERIAL {
 		ATTRIBUTES attrib;
 		const char* name;
@@ -43,9 +94,314 @@ namespace H2B {
 		BATCH drawInfo;
 		unsigned materialIndex;
 	};
+	// Returns true if the 4 byte tag starts a v2 container
+	inline bool IsVersion2(const char* version) {
+		return std::memcmp(version, "H2B2", 4) == 0;
+	}
+
+	// Returns true if the 4 byte version tag is one this parser understands ("019d" or newer, or "H2B2")
+	inline bool IsSupportedVersion(const char* version) {
+		return IsVersion2(version) || !(version[1] < '1' || version[2] < '9' || version[3] < 'd');
+	}
+
+	// Bounds checked cursor over a .h2b file that is already in memory
+	class MemoryReader
+	{
+		const char* data;
+		size_t size;
+		size_t offset = 0;
+	public:
+		MemoryReader(const void* _data, size_t _size) : data(static_cast<const char*>(_data)), size(_size) {}
+
+		// Returns the address of the next "bytes" bytes and moves past them, nullptr if they run past the end
+		const char* Skip(size_t bytes) {
+			if (bytes > size - offset)
+				return nullptr;
+			const char* at = data + offset;
+			offset += bytes;
+			return at;
+		}
+		// Copies the next "bytes" bytes into "out", false if they run past the end
+		bool Read(void* out, size_t bytes) {
+			const char* at = Skip(bytes);
+			if (at == nullptr)
+				return false;
+			std::memcpy(out, at, bytes);
+			return true;
+		}
+		// Moves past a '\0' terminated string, "out" points at it in place (nullptr when empty)
+		// Returns false if the terminator is not found before the end
+		bool ReadString(const char*& out) {
+			const void* end = std::memchr(data + offset, '\0', size - offset);
+			if (end == nullptr)
+				return false;
+			const char* at = data + offset;
+			offset = static_cast<const char*>(end) - data + 1;
+			out = (*at != '\0') ? at : nullptr;
+			return true;
+		}
+		inline size_t Offset() const { return offset; }
+		inline size_t Remaining() const { return size - offset; }
+	};
+
+	// Decodes the 20 byte header of an in-memory v1 .h2b file (version, vertex/index/material/mesh counts)
+	inline bool DecodeHeader(MemoryReader& reader, char* version, unsigned& vertexCount,
+		unsigned& indexCount, unsigned& materialCount, unsigned& meshCount)
+	{
+		return reader.Read(version, 4) && IsSupportedVersion(version) && !IsVersion2(version) &&
+			reader.Read(&vertexCount, 4) && reader.Read(&indexCount, 4) &&
+			reader.Read(&materialCount, 4) && reader.Read(&meshCount, 4);
+	}
+
+	// Decodes the material, batch and mesh tables that follow the index data of an in-memory .h2b file
+	// Every name is passed through "store" (which receives a pointer to it in place) to get the pointer kept in the tables
+	template <typename StoreString>
+	bool DecodeTables(MemoryReader& reader, unsigned materialCount, unsigned meshCount,
+		std::vector<MATERIAL>& materials, std::vector<BATCH>& batches, std::vector<MESH>& meshes, StoreString store)
+	{
+		// a material is at least 80 bytes plus 10 terminators, reject absurd counts before allocating
+		if (materialCount > reader.Remaining() / 90)
+			return false;
+		materials.resize(materialCount);
+		for (unsigned i = 0; i < materialCount; ++i) {
+			if (!reader.Read(&materials[i].attrib, 80))
+				return false;
+			for (int j = 0; j < 10; ++j) {
+				const char*& name = *((&materials[i].name) + j);
+				if (!reader.ReadString(name))
+					return false;
+				if (name != nullptr)
+					name = store(name);
+			}
+		}
+		batches.resize(materialCount);
+		// a mesh is at least a terminator plus 12 bytes
+		if (!reader.Read(batches.data(), 8 * size_t(materialCount)) || meshCount > reader.Remaining() / 13)
+			return false;
+		meshes.resize(meshCount);
+		for (unsigned i = 0; i < meshCount; ++i) {
+			if (!reader.ReadString(meshes[i].name) ||
+				!reader.Read(&meshes[i].drawInfo, 8) ||
+				!reader.Read(&meshes[i].materialIndex, 4))
+				return false;
+			if (meshes[i].name != nullptr)
+				meshes[i].name = store(meshes[i].name);
+		}
+		return true;
+	}
+
+	// Returns the entry of the first section of "type" in an in-memory v2 file, nullptr if there is none
+	// Only sections that lie completely inside the file are returned.
+	inline const SECTION_V2* FindSectionV2(const char* data, size_t size, unsigned type)
+	{
+		HEADER_V2 header;
+		if (size < sizeof(HEADER_V2))
+			return nullptr;
+		std::memcpy(&header, data, sizeof(HEADER_V2));
+		if (!IsVersion2(header.magic) || header.headerSize < sizeof(HEADER_V2) || header.headerSize > size ||
+			header.sectionCount > (size - header.headerSize) / sizeof(SECTION_V2))
+			return nullptr;
+		const SECTION_V2* sections = reinterpret_cast<const SECTION_V2*>(data + header.headerSize);
+		for (unsigned i = 0; i < header.sectionCount; ++i)
+			if (sections[i].type == type)
+				return (sections[i].offset <= size && sections[i].size <= size - sections[i].offset) ? &sections[i] : nullptr;
+		return nullptr;
+	}
+
+	// Copies every section of an in-memory v2 file that isn't one of the standard ones (types 1 - 6)
+	inline void CopyExtraSectionsV2(const char* data, size_t size, std::vector<EXTRA_SECTION>& extras)
+	{
+		extras.clear();
+		HEADER_V2 header;
+		if (size < sizeof(HEADER_V2))
+			return;
+		std::memcpy(&header, data, sizeof(HEADER_V2));
+		if (!IsVersion2(header.magic) || header.headerSize < sizeof(HEADER_V2) || header.headerSize > size ||
+			header.sectionCount > (size - header.headerSize) / sizeof(SECTION_V2))
+			return;
+		const SECTION_V2* sections = reinterpret_cast<const SECTION_V2*>(data + header.headerSize);
+		for (unsigned i = 0; i < header.sectionCount; ++i)
+			if (sections[i].type > SECTION_STRINGS && sections[i].offset <= size && sections[i].size <= size - sections[i].offset)
+				extras.push_back(EXTRA_SECTION{ sections[i].type,
+					std::vector<char>(data + sections[i].offset, data + sections[i].offset + sections[i].size) });
+	}
+
+	// Decodes an in-memory v2 file. vertexData & indexData point at the (aligned) geometry sections in place,
+	// every name is passed through "store" (which receives a pointer into the string table) like in DecodeTables
+	template <typename StoreString>
+	bool DecodeV2(const char* data, size_t size, char* version, unsigned& vertexCount, unsigned& indexCount,
+		unsigned& materialCount, unsigned& meshCount, const char*& vertexData, const char*& indexData,
+		std::vector<MATERIAL>& materials, std::vector<BATCH>& batches, std::vector<MESH>& meshes, StoreString store)
+	{
+		HEADER_V2 header;
+		if (size < sizeof(HEADER_V2))
+			return false;
+		std::memcpy(&header, data, sizeof(HEADER_V2));
+		if (!IsVersion2(header.magic))
+			return false;
+		std::memcpy(version, header.magic, 4);
+		vertexCount = header.vertexCount;
+		indexCount = header.indexCount;
+		materialCount = header.materialCount;
+		meshCount = header.meshCount;
+
+		// every section must be present with exactly the size its count implies
+		auto section = [&](unsigned type, size_t expectedSize) -> const char* {
+			const SECTION_V2* found = FindSectionV2(data, size, type);
+			if (found == nullptr || found->size != expectedSize || found->offset % SECTION_ALIGNMENT != 0)
+				return nullptr;
+			return data + found->offset;
+		};
+		vertexData = section(SECTION_VERTICES, sizeof(VERTEX) * size_t(vertexCount));
+		indexData = section(SECTION_INDICES, sizeof(unsigned) * size_t(indexCount));
+		const char* materialData = section(SECTION_MATERIALS, sizeof(MATERIAL_V2) * size_t(materialCount));
+		const char* batchData = section(SECTION_BATCHES, sizeof(BATCH) * size_t(materialCount));
+		const char* meshData = section(SECTION_MESHES, sizeof(MESH_V2) * size_t(meshCount));
+		if (!vertexData || !indexData || !materialData || !batchData || !meshData)
+			return false;
+		const SECTION_V2* strings = FindSectionV2(data, size, SECTION_STRINGS);
+		const char* stringData = strings ? data + strings->offset : nullptr;
+		size_t stringSize = strings ? strings->size : 0;
+
+		// string table offset -> name (nullptr for NO_STRING), false if it isn't a terminated string of the table
+		auto name = [&](unsigned offset, const char*& out) {
+			out = nullptr;
+			if (offset == NO_STRING)
+				return true;
+			if (offset >= stringSize || std::memchr(stringData + offset, '\0', stringSize - offset) == nullptr)
+				return false;
+			out = store(stringData + offset);
+			return true;
+		};
+		materials.resize(materialCount);
+		for (unsigned i = 0; i < materialCount; ++i) {
+			MATERIAL_V2 record;
+			std::memcpy(&record, materialData + sizeof(MATERIAL_V2) * i, sizeof(MATERIAL_V2));
+			materials[i].attrib = record.attrib;
+			for (int j = 0; j < 10; ++j)
+				if (!name(record.names[j], *((&materials[i].name) + j)))
+					return false;
+		}
+		batches.resize(materialCount);
+		std::memcpy(batches.data(), batchData, sizeof(BATCH) * size_t(materialCount));
+		meshes.resize(meshCount);
+		for (unsigned i = 0; i < meshCount; ++i) {
+			MESH_V2 record;
+			std::memcpy(&record, meshData + sizeof(MESH_V2) * i, sizeof(MESH_V2));
+			if (!name(record.name, meshes[i].name))
+				return false;
+			meshes[i].drawInfo = record.drawInfo;
+			meshes[i].materialIndex = record.materialIndex;
+		}
+		return true;
+	}
+
+	// Interned, contiguous storage for the names of a parsed file.
+	// Strings are packed into a few growing blocks that never move, so returned pointers stay
+	// valid until Clear, which frees everything at once. Equal strings are only stored once.
+	class StringArena
+	{
+		static constexpr size_t firstBlockSize = 256;
+		static constexpr size_t maxBlockSize = 64 * 1024;
+		struct ENTRY {
+			uint32_t hash;
+			const char* str;
+		};
+		std::vector<std::unique_ptr<char[]>> blocks;
+		size_t blockSize = 0; // capacity of blocks.back()
+		size_t blockUsed = 0; // bytes used in blocks.back()
+		std::vector<ENTRY> table; // open addressing hash set, size is a power of 2 (or 0)
+		size_t count = 0;
+
+		static uint32_t Hash(const char* str, size_t length) {
+			uint32_t hash = 2166136261u; // FNV-1a
+			for (size_t i = 0; i < length; ++i)
+				hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619u;
+			return hash;
+		}
+		char* Allocate(size_t bytes) {
+			if (bytes > maxBlockSize) {
+				// oversized strings get a block of their own, kept behind the current one
+				blocks.insert(blocks.begin(), std::unique_ptr<char[]>(new char[bytes]));
+				return blocks.front().get();
+			}
+			if (blocks.empty() || blockSize - blockUsed < bytes) {
+				size_t next = blocks.empty() ? firstBlockSize : blockSize * 2;
+				blockSize = next < maxBlockSize ? next : maxBlockSize;
+				if (blockSize < bytes)
+					blockSize = bytes;
+				blocks.emplace_back(new char[blockSize]);
+				blockUsed = 0;
+			}
+			char* at = blocks.back().get() + blockUsed;
+			blockUsed += bytes;
+			return at;
+		}
+		void Grow() {
+			std::vector<ENTRY> old(table.empty() ? 16 : table.size() * 2, ENTRY{ 0, nullptr });
+			old.swap(table);
+			for (auto& e : old)
+				if (e.str != nullptr) {
+					size_t slot = e.hash & (table.size() - 1);
+					while (table[slot].str != nullptr)
+						slot = (slot + 1) & (table.size() - 1);
+					table[slot] = e;
+				}
+		}
+	public:
+		// Returns the arena's copy of "str", storing it first if it has not been seen before
+		const char* Intern(const char* str) {
+			return Intern(str, std::strlen(str));
+		}
+		// Same for the first "length" chars of "str" (need not be '\0' terminated), the copy is terminated
+		const char* Intern(const char* str, size_t length) {
+			uint32_t hash = Hash(str, length);
+			if ((count + 1) * 2 > table.size())
+				Grow();
+			size_t slot = hash & (table.size() - 1);
+			while (table[slot].str != nullptr) {
+				if (table[slot].hash == hash && std::strncmp(table[slot].str, str, length) == 0 && table[slot].str[length] == '\0')
+					return table[slot].str;
+				slot = (slot + 1) & (table.size() - 1);
+			}
+			char* copy = Allocate(length + 1);
+			std::memcpy(copy, str, length);
+			copy[length] = '\0';
+			table[slot] = ENTRY{ hash, copy };
+			++count;
+			return copy;
+		}
+		// Frees every string at once, all pointers handed out become invalid
+		void Clear() {
+			blocks.clear();
+			table.clear();
+			blockSize = blockUsed = count = 0;
+		}
+		// Returns the number of unique strings stored
+		inline size_t Count() const { return count; }
+	};
+
+	// Fills the bounds of a whole file & of each of its meshes (from the vertices each mesh's indices use)
+	inline void ComputeFileBounds(const VERTEX* vertices, unsigned vertexCount, const unsigned* indices, unsigned indexCount,
+		const std::vector<MESH>& meshes, BOUNDS& bounds, std::vector<BOUNDS>& meshBounds)
+	{
+		bounds = ComputeBounds(vertices, sizeof(VERTEX), nullptr, vertexCount, vertexCount);
+		meshBounds.resize(meshes.size());
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			BATCH draw = meshes[i].drawInfo;
+			if (draw.indexOffset > indexCount || draw.indexCount > indexCount - draw.indexOffset)
+				draw = { 0, 0 };
+			meshBounds[i] = ComputeBounds(vertices, sizeof(VERTEX), indices + draw.indexOffset, draw.indexCount, vertexCount);
+		}
+	}
+
+	class StreamParser;
+
 	class Parser
 	{
-		std::set<std::string> file_strings;
+		StringArena file_strings;
+		// decodes straight into a Parser (h2bStreamParser.h)
+		friend class StreamParser;
 	public:
 		char version[4];
 		unsigned vertexCount;
@@ -57,6 +413,11 @@ namespace H2B {
 		std::vector<MATERIAL> materials;
 		std::vector<BATCH> batches;
 		std::vector<MESH> meshes;
+		// optional v2 sections (SECTION_MESHLETS...), empty for "019d" files
+		std::vector<EXTRA_SECTION> extraSections;
+		// box & sphere around the file's vertices & around each mesh's, computed while parsing
+		BOUNDS bounds = {};
+		std::vector<BOUNDS> meshBounds;
 		bool Parse(const char* h2bPath)
 		{
 			Clear();
@@ -67,8 +428,13 @@ namespace H2B {
 			if (file.is_open() == false)
 				return false;
 			file.read(version, 4);
-			if (version[1] < '1' || version[2] < '9' || version[3] < 'd')
+			if (!IsSupportedVersion(version))
 				return false;
+			// v2 containers are decoded through their section table
+			if (IsVersion2(version)) {
+				file.close();
+				return ParseBuffered(h2bPath);
+			}
 			file.read(reinterpret_cast<char*>(&vertexCount), 4);
 			file.read(reinterpret_cast<char*>(&indexCount), 4);
 			file.read(reinterpret_cast<char*>(&materialCount), 4);
@@ -85,8 +451,7 @@ namespace H2B {
 					*((&materials[i].name) + j) = nullptr;
 					file.getline(buffer, 260, '\0');
 					if (buffer[0] != '\0') {
-						auto last = file_strings.insert(buffer);
-						*((&materials[i].name) + j) = last.first->c_str();
+						*((&materials[i].name) + j) = file_strings.Intern(buffer);
 					}
 				}
 			}
@@ -98,23 +463,203 @@ namespace H2B {
 				meshes[i].name = nullptr;
 				file.getline(buffer, 260, '\0');
 				if (buffer[0] != '\0') {
-					auto last = file_strings.insert(buffer);
-					meshes[i].name = last.first->c_str();
+					meshes[i].name = file_strings.Intern(buffer);
 				}
 				file.read(reinterpret_cast<char*>(&meshes[i].drawInfo), 8);
 				file.read(reinterpret_cast<char*>(&meshes[i].materialIndex), 4);
 			}
+			ComputeFileBounds(vertices.data(), vertexCount, indices.data(), indexCount, meshes, bounds, meshBounds);
+			return true;
+		}
+		// Decodes a complete .h2b file that is already in memory, every read is bounds checked
+		// const void* data - The file contents
+		// size_t size - The size of the file contents in bytes
+		bool ParseFromMemory(const void* data, size_t size)
+		{
+			Clear();
+			const char* vertexData = nullptr;
+			const char* indexData = nullptr;
+			auto storeName = [this](const char* name) { return file_strings.Intern(name); };
+			if (size >= 4 && IsVersion2(static_cast<const char*>(data))) {
+				if (!DecodeV2(static_cast<const char*>(data), size, version, vertexCount, indexCount, materialCount,
+					meshCount, vertexData, indexData, materials, batches, meshes, storeName)) {
+					Clear();
+					return false;
+				}
+				const VERTEX* firstVertex = reinterpret_cast<const VERTEX*>(vertexData);
+				vertices.assign(firstVertex, firstVertex + vertexCount);
+				indices.resize(indexCount);
+				std::memcpy(indices.data(), indexData, size_t(4) * indexCount);
+				CopyExtraSectionsV2(static_cast<const char*>(data), size, extraSections);
+				ComputeFileBounds(vertices.data(), vertexCount, indices.data(), indexCount, meshes, bounds, meshBounds);
+				return true;
+			}
+			MemoryReader reader(data, size);
+			if (!DecodeHeader(reader, version, vertexCount, indexCount, materialCount, meshCount)) {
+				Clear();
+				return false;
+			}
+			vertexData = reader.Skip(size_t(36) * vertexCount);
+			indexData = reader.Skip(size_t(4) * indexCount);
+			if (vertexData == nullptr || indexData == nullptr) {
+				Clear();
+				return false;
+			}
+			// assign straight from the buffer (resize would zero everything first)
+			const VERTEX* firstVertex = reinterpret_cast<const VERTEX*>(vertexData);
+			vertices.assign(firstVertex, firstVertex + vertexCount);
+			indices.resize(indexCount);
+			std::memcpy(indices.data(), indexData, size_t(4) * indexCount);
+			if (!DecodeTables(reader, materialCount, meshCount, materials, batches, meshes, storeName)) {
+				Clear();
+				return false;
+			}
+			ComputeFileBounds(vertices.data(), vertexCount, indices.data(), indexCount, meshes, bounds, meshBounds);
+			return true;
+		}
+		// Reads a whole file into one buffer with a single read, false if it can't be read (or is empty)
+		// std::unique_ptr<char[]>& fileBuffer - Receives the contents
+		// size_t& size - Receives the size of the contents in bytes
+		static bool ReadFile(const char* h2bPath, std::unique_ptr<char[]>& fileBuffer, size_t& size)
+		{
+			std::ifstream file;
+			file.rdbuf()->pubsetbuf(nullptr, 0); // unbuffered, the one read goes straight into fileBuffer
+			file.open(h2bPath,	std::ios_base::in | 
+								std::ios_base::binary | 
+								std::ios_base::ate);
+			if (file.is_open() == false)
+				return false;
+			std::streamoff length = file.tellg();
+			if (length <= 0)
+				return false;
+			// left uninitialized on purpose, the read overwrites all of it
+			fileBuffer.reset(new char[static_cast<size_t>(length)]);
+			file.seekg(0);
+			if (!file.read(fileBuffer.get(), length))
+				return false;
+			size = static_cast<size_t>(length);
 			return true;
 		}
+		// Reads the whole .h2b file into one buffer with a single read and decodes it from memory
+		// Same result as Parse without the per field stream reads
+		bool ParseBuffered(const char* h2bPath)
+		{
+			Clear();
+			std::unique_ptr<char[]> fileBuffer;
+			size_t size = 0;
+			if (!ReadFile(h2bPath, fileBuffer, size))
+				return false;
+			return ParseFromMemory(fileBuffer.get(), size);
+		}
 		void Clear()
 		{
 			*reinterpret_cast<unsigned*>(version) = 0;
-			file_strings.clear();
+			file_strings.Clear();
 			vertices.clear();
 			indices.clear();
 			materials.clear();
 			batches.clear();
 			meshes.clear();
+			extraSections.clear();
+			bounds = BOUNDS();
+			meshBounds.clear();
+		}
+		// Returns the optional section of "type" (nullptr if the file has none)
+		const EXTRA_SECTION* FindSection(unsigned type) const
+		{
+			for (auto& e : extraSections)
+				if (e.type == type)
+					return &e;
+			return nullptr;
+		}
+	};
+
+	// Zero-copy alternative to Parser, the .h2b file is memory mapped instead of read.
+	// vertices & indices point straight into the mapping and every material/mesh name is read in place,
+	// so the data stays valid until the next Parse/Clear or until the parser is destroyed.
+	class MappedParser
+	{
+		MappedFile file;
+	public:
+		char version[4];
+		unsigned vertexCount;
+		unsigned indexCount;
+		unsigned materialCount;
+		unsigned meshCount;
+		const VERTEX* vertices = nullptr;
+		const unsigned* indices = nullptr;
+		std::vector<MATERIAL> materials;
+		std::vector<BATCH> batches;
+		std::vector<MESH> meshes;
+		// box & sphere around the file's vertices & around each mesh's, computed while parsing
+		BOUNDS bounds = {};
+		std::vector<BOUNDS> meshBounds;
+		bool Parse(const char* h2bPath)
+		{
+			Clear();
+			if (file.Open(h2bPath) == false)
+				return false;
+			auto inPlace = [](const char* name) { return name; };
+			// v2 containers: jump straight to the aligned sections, names are used in place in the string table
+			if (file.Size() >= 4 && IsVersion2(file.Data())) {
+				const char* vertexData = nullptr;
+				const char* indexData = nullptr;
+				if (!DecodeV2(file.Data(), file.Size(), version, vertexCount, indexCount, materialCount, meshCount,
+					vertexData, indexData, materials, batches, meshes, inPlace)) {
+					Clear();
+					return false;
+				}
+				vertices = reinterpret_cast<const VERTEX*>(vertexData);
+				indices = reinterpret_cast<const unsigned*>(indexData);
+				ComputeFileBounds(vertices, vertexCount, indices, indexCount, meshes, bounds, meshBounds);
+				return true;
+			}
+			MemoryReader reader(file.Data(), file.Size());
+			if (!DecodeHeader(reader, version, vertexCount, indexCount, materialCount, meshCount)) {
+				Clear();
+				return false;
+			}
+			vertices = reinterpret_cast<const VERTEX*>(reader.Skip(size_t(36) * vertexCount));
+			indices = reinterpret_cast<const unsigned*>(reader.Skip(size_t(4) * indexCount));
+			// index data is always 4 byte aligned in a valid file since the header is 20 bytes
+			if (vertices == nullptr || indices == nullptr ||
+				reinterpret_cast<uintptr_t>(indices) % alignof(unsigned) != 0) {
+				Clear();
+				return false;
+			}
+			// names are used in place, they live as long as the mapping
+			if (!DecodeTables(reader, materialCount, meshCount, materials, batches, meshes, inPlace)) {
+				Clear();
+				return false;
+			}
+			ComputeFileBounds(vertices, vertexCount, indices, indexCount, meshes, bounds, meshBounds);
+			return true;
+		}
+		// Returns the optional v2 section of "type" in place (nullptr if the file has none or isn't v2)
+		// unsigned& size - Receives the section's size in bytes
+		const char* FindSection(unsigned type, unsigned& size) const
+		{
+			size = 0;
+			if (!file.IsOpen() || file.Size() < 4 || !IsVersion2(file.Data()))
+				return nullptr;
+			const SECTION_V2* found = FindSectionV2(file.Data(), file.Size(), type);
+			if (found == nullptr)
+				return nullptr;
+			size = found->size;
+			return file.Data() + found->offset;
+		}
+		void Clear()
+		{
+			*reinterpret_cast<unsigned*>(version) = 0;
+			vertexCount = indexCount = materialCount = meshCount = 0;
+			vertices = nullptr;
+			indices = nullptr;
+			materials.clear();
+			batches.clear();
+			meshes.clear();
+			bounds = BOUNDS();
+			meshBounds.clear();
+			file.Close();
 		}
 	};
 }
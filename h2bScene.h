@@ -0,0 +1,228 @@
+#ifndef _H2BSCENE_H_
+#define _H2BSCENE_H_
+// Compiled GameLevel ("H2L1"), made from GameLevel.txt by Tools/levelCook.
+// Laid out like an H2B v2 container: a fixed header, a table of 16 byte aligned sections and a string table,
+// so a mapped file is used in place, the entity records are read straight out of the mapping.
+//   SCENE_ENTITIES - SCENE_ENTITY[entityCount], one per MESH block, mesh is an index into SCENE_MESHES
+//   SCENE_LIGHTS   - SCENE_ENTITY[lightCount], one per LIGHT block
+//   SCENE_CAMERAS  - SCENE_ENTITY[cameraCount], one per CAMERA block
+//   SCENE_MESHES   - unsigned[meshCount], string table offsets of each unique model file (relative to the model folder)
+//   SCENE_STRINGS  - '\0' terminated strings
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "h2bParser.h"
+#include "mapped_file.h"
+#include "game_level_parser.h"
+
+namespace H2B {
+
+	struct SCENE_HEADER {
+		char magic[4]; // "H2L1"
+		unsigned headerSize; // bytes before the section table
+		unsigned entityCount, lightCount, cameraCount, meshCount;
+		unsigned sectionCount;
+		unsigned reserved;
+	};
+	struct SCENE_ENTITY {
+		unsigned type; // LEVEL_OBJECT_TYPE
+		unsigned name; // string table offset
+		unsigned mesh; // SCENE_MESHES index, NO_SCENE_MESH for lights & cameras
+		unsigned reserved;
+		float world[16]; // row major like the text file
+	};
+	enum SCENE_SECTION_TYPE : unsigned {
+		SCENE_ENTITIES = 1,
+		SCENE_LIGHTS = 2,
+		SCENE_CAMERAS = 3,
+		SCENE_MESHES = 4,
+		SCENE_STRINGS = 5,
+	};
+	static constexpr unsigned NO_SCENE_MESH = 0xFFFFFFFFu;
+	static_assert(sizeof(SCENE_HEADER) == 32 && sizeof(SCENE_ENTITY) == 80, "H2L1 layout");
+
+	// Returns the compiled scene path that goes with a GameLevel.txt ("GameLevel.h2l" next to it)
+	inline std::string GetScenePath(const char* gameLevelPath)
+	{
+		std::string path = gameLevelPath;
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of("/\\");
+		if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+			path.erase(dot);
+		return path + ".h2l";
+	}
+
+	// A compiled scene read in place from its mapping, valid until Close (or the next Open)
+	class MappedScene
+	{
+		MappedFile file;
+		const char* strings = nullptr;
+		size_t stringSize = 0;
+	public:
+		const SCENE_ENTITY* entities = nullptr;
+		const SCENE_ENTITY* lights = nullptr;
+		const SCENE_ENTITY* cameras = nullptr;
+		const unsigned* meshes = nullptr;
+		unsigned entityCount = 0, lightCount = 0, cameraCount = 0, meshCount = 0;
+
+		//Maps a compiled scene and checks its header & section table (the records themselves are not touched)
+		//Returns false if the file can't be opened or isn't a complete H2L1 scene
+		bool Open(const char* scenePath) {
+			Close();
+			if (!file.Open(scenePath) || file.Size() < sizeof(SCENE_HEADER))
+				return Fail();
+			const char* data = file.Data();
+			size_t size = file.Size();
+			SCENE_HEADER header;
+			std::memcpy(&header, data, sizeof(SCENE_HEADER));
+			if (std::memcmp(header.magic, "H2L1", 4) != 0 || header.headerSize < sizeof(SCENE_HEADER) || header.headerSize > size ||
+				header.sectionCount > (size - header.headerSize) / sizeof(SECTION_V2))
+				return Fail();
+			const SECTION_V2* sections = reinterpret_cast<const SECTION_V2*>(data + header.headerSize);
+			// every section present, aligned and exactly the size its count implies
+			auto section = [&](unsigned type, size_t expectedSize) -> const char* {
+				for (unsigned i = 0; i < header.sectionCount; ++i)
+					if (sections[i].type == type)
+						return sections[i].offset <= size && sections[i].size == expectedSize && expectedSize <= size - sections[i].offset &&
+							sections[i].offset % SECTION_ALIGNMENT == 0 ? data + sections[i].offset : nullptr;
+				return nullptr;
+			};
+			entities = reinterpret_cast<const SCENE_ENTITY*>(section(SCENE_ENTITIES, sizeof(SCENE_ENTITY) * size_t(header.entityCount)));
+			lights = reinterpret_cast<const SCENE_ENTITY*>(section(SCENE_LIGHTS, sizeof(SCENE_ENTITY) * size_t(header.lightCount)));
+			cameras = reinterpret_cast<const SCENE_ENTITY*>(section(SCENE_CAMERAS, sizeof(SCENE_ENTITY) * size_t(header.cameraCount)));
+			meshes = reinterpret_cast<const unsigned*>(section(SCENE_MESHES, sizeof(unsigned) * size_t(header.meshCount)));
+			const SECTION_V2* stringSection = nullptr;
+			for (unsigned i = 0; i < header.sectionCount; ++i)
+				if (sections[i].type == SCENE_STRINGS)
+					stringSection = &sections[i];
+			if (!entities || !lights || !cameras || !meshes || !stringSection || stringSection->size == 0 ||
+				stringSection->offset > size || stringSection->size > size - stringSection->offset)
+				return Fail();
+			strings = data + stringSection->offset;
+			stringSize = stringSection->size;
+			// a terminated table makes every in range offset a terminated string, so names need no check per record
+			if (strings[stringSize - 1] != '\0')
+				return Fail();
+			entityCount = header.entityCount;
+			lightCount = header.lightCount;
+			cameraCount = header.cameraCount;
+			meshCount = header.meshCount;
+			return true;
+		}
+
+		//Returns the string at a string table offset, "" if the offset is outside the table
+		inline const char* GetString(unsigned offset) const {
+			return offset < stringSize ? strings + offset : "";
+		}
+
+		//Returns the model file of an entity (relative to the model folder), nullptr if it has none
+		inline const char* GetMeshFile(const SCENE_ENTITY& entity) const {
+			return entity.mesh < meshCount ? GetString(meshes[entity.mesh]) : nullptr;
+		}
+
+		//Unmaps the scene, every pointer into it becomes invalid
+		void Close() {
+			file.Close();
+			strings = nullptr;
+			stringSize = 0;
+			entities = lights = cameras = nullptr;
+			meshes = nullptr;
+			entityCount = lightCount = cameraCount = meshCount = 0;
+		}
+
+	private:
+		bool Fail() {
+			Close();
+			return false;
+		}
+	};
+
+	// Writes a compiled scene from a parsed GameLevel.txt
+	// const std::vector<std::string>& meshFiles - Model file of each of level.meshes (relative to the model folder)
+	inline bool WriteScene(const char* scenePath, const GameLevelParser& level, const std::vector<std::string>& meshFiles)
+	{
+		if (meshFiles.size() != level.meshes.size())
+			return false;
+		// string table, every distinct string stored once
+		std::vector<char> strings;
+		std::unordered_map<std::string, unsigned> stringOffsets;
+		auto addString = [&](const std::string& str) -> unsigned {
+			auto found = stringOffsets.find(str);
+			if (found != stringOffsets.end())
+				return found->second;
+			unsigned offset = static_cast<unsigned>(strings.size());
+			strings.insert(strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+			stringOffsets.emplace(str, offset);
+			return offset;
+		};
+		std::vector<unsigned> meshes;
+		std::unordered_map<std::string, unsigned> meshIds;
+		auto record = [&](const LEVEL_OBJECT& object, unsigned mesh) {
+			SCENE_ENTITY entity = { static_cast<unsigned>(object.type), addString(object.name), mesh, 0, {} };
+			std::memcpy(entity.world, object.world, sizeof(entity.world));
+			return entity;
+		};
+		std::vector<SCENE_ENTITY> entities, lights, cameras;
+		for (size_t i = 0; i < level.meshes.size(); ++i) {
+			auto id = meshIds.emplace(meshFiles[i], static_cast<unsigned>(meshes.size()));
+			if (id.second)
+				meshes.push_back(addString(meshFiles[i]));
+			entities.push_back(record(level.meshes[i], id.first->second));
+		}
+		for (auto& light : level.lights)
+			lights.push_back(record(light, NO_SCENE_MESH));
+		for (auto& camera : level.cameras)
+			cameras.push_back(record(camera, NO_SCENE_MESH));
+		strings.push_back('\0'); // keeps the table terminated even with no strings
+
+		struct PAYLOAD {
+			unsigned type;
+			const void* data;
+			size_t size;
+		};
+		const PAYLOAD payloads[] = {
+			{ SCENE_ENTITIES, entities.data(), sizeof(SCENE_ENTITY) * entities.size() },
+			{ SCENE_LIGHTS, lights.data(), sizeof(SCENE_ENTITY) * lights.size() },
+			{ SCENE_CAMERAS, cameras.data(), sizeof(SCENE_ENTITY) * cameras.size() },
+			{ SCENE_MESHES, meshes.data(), sizeof(unsigned) * meshes.size() },
+			{ SCENE_STRINGS, strings.data(), strings.size() },
+		};
+		const size_t sectionCount = sizeof(payloads) / sizeof(payloads[0]);
+		auto align = [](size_t offset) { return (offset + SECTION_ALIGNMENT - 1) & ~size_t(SECTION_ALIGNMENT - 1); };
+		SCENE_HEADER header = {};
+		std::memcpy(header.magic, "H2L1", 4);
+		header.headerSize = sizeof(SCENE_HEADER);
+		header.entityCount = static_cast<unsigned>(entities.size());
+		header.lightCount = static_cast<unsigned>(lights.size());
+		header.cameraCount = static_cast<unsigned>(cameras.size());
+		header.meshCount = static_cast<unsigned>(meshes.size());
+		header.sectionCount = sectionCount;
+		SECTION_V2 sections[sectionCount];
+		size_t offset = align(sizeof(SCENE_HEADER) + sizeof(sections));
+		for (size_t i = 0; i < sectionCount; ++i) {
+			if (offset + payloads[i].size > 0xFFFFFFFFull)
+				return false; // offsets are 32 bit
+			sections[i] = SECTION_V2{ payloads[i].type, static_cast<unsigned>(offset), static_cast<unsigned>(payloads[i].size), 0 };
+			offset = align(offset + payloads[i].size);
+		}
+
+		std::ofstream file(scenePath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (file.is_open() == false)
+			return false;
+		const char zeros[SECTION_ALIGNMENT] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(SCENE_HEADER));
+		file.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+		size_t written = sizeof(SCENE_HEADER) + sizeof(sections);
+		for (size_t i = 0; i < sectionCount; ++i) {
+			file.write(zeros, sections[i].offset - written);
+			if (payloads[i].size)
+				file.write(static_cast<const char*>(payloads[i].data), payloads[i].size);
+			written = sections[i].offset + payloads[i].size;
+		}
+		file.write(zeros, align(written) - written);
+		return file.good();
+	}
+}
+#endif
@@ -0,0 +1,11 @@
+#ifndef _H2BSIMD_H_
+#define _H2BSIMD_H_
+// Picks the SIMD path used by the .h2b processing kernels.
+// SSE2 is part of every x64 target; anything else uses the scalar loops each kernel also has.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define H2B_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define H2B_SIMD_SSE2 0
+#endif
+#endif
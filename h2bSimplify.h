@@ -0,0 +1,413 @@
+#ifndef _H2BSIMPLIFY_H_
+#define _H2BSIMPLIFY_H_
+// Quadric error mesh simplification & LOD chains for .h2b files.
+// Simplification collapses edges onto existing vertices (half edge collapses, no new vertices), one BATCH/MESH range
+// at a time with the range's open borders locked, so every LOD keeps the file's mesh & material ranges and no cracks
+// open up between ranges. uv/normal seams only collapse along the seam, so no attribute gets stretched across it.
+// LOD index lists are stored after the file's own indices in a v2 SECTION_LODS and drawn with the same vertices.
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "h2bParser.h"
+
+namespace H2B {
+
+	// Layout of a SECTION_LODS section: LOD_HEADER, LOD_INFO[lodCount], BATCH[lodCount * meshCount], unsigned[indexCount]
+	struct LOD_HEADER {
+		unsigned lodCount; // levels after the file's own indices (LOD 0)
+		unsigned meshCount; // must match the file
+		unsigned indexCount; // indices of all levels
+		unsigned reserved;
+	};
+	struct LOD_INFO {
+		float error; // largest geometric error of the level, in model units
+		unsigned triangleCount;
+		unsigned reserved[2];
+	};
+	static_assert(sizeof(LOD_HEADER) == 16 && sizeof(LOD_INFO) == 16, "SECTION_LODS layout");
+
+	// Decoded LOD chain of one file
+	struct LOD_CHAIN {
+		std::vector<LOD_INFO> levels; // LOD 1, 2, ...
+		std::vector<BATCH> draws; // levels.size() * meshCount, offsets into indices
+		std::vector<unsigned> indices;
+
+		//Returns the draw range of mesh "mesh" in level "lod" (1 based, like the LOD numbers)
+		inline const BATCH& GetDraw(unsigned lod, size_t mesh, size_t meshCount) const {
+			return draws[(lod - 1) * meshCount + mesh];
+		}
+	};
+
+	// Symmetric 4x4 error quadric (sum of squared distances to a set of planes)
+	struct QUADRIC {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0, b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+		inline void AddPlane(const double n[3], double d) {
+			a00 += n[0] * n[0]; a01 += n[0] * n[1]; a02 += n[0] * n[2];
+			a11 += n[1] * n[1]; a12 += n[1] * n[2]; a22 += n[2] * n[2];
+			b0 += n[0] * d; b1 += n[1] * d; b2 += n[2] * d;
+			c += d * d;
+		}
+		inline void Add(const QUADRIC& q) {
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+		}
+		//Returns the summed squared distance of point p to the planes
+		inline double Evaluate(const float p[3]) const {
+			double x = p[0], y = p[1], z = p[2];
+			double result = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2 * (b0 * x + b1 * y + b2 * z) + c;
+			return result > 0 ? result : 0;
+		}
+	};
+
+	// Numbers vertices by position: vertices with bit identical positions (copies split by uv/normal seams) share an id
+	// Returns the number of distinct positions
+	// std::vector<unsigned>& positionOf - Receives the position id of each vertex
+	inline unsigned GetPositionIds(const VERTEX* vertices, unsigned vertexCount, std::vector<unsigned>& positionOf)
+	{
+		positionOf.assign(vertexCount, ~0u);
+		size_t tableSize = 16;
+		while (tableSize < size_t(vertexCount) * 2)
+			tableSize *= 2;
+		std::vector<unsigned> table(tableSize, ~0u); // first vertex of each position
+		unsigned count = 0;
+		for (unsigned v = 0; v < vertexCount; ++v) {
+			uint32_t hash = 2166136261u; // FNV-1a
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertices[v].pos);
+			for (size_t b = 0; b < sizeof(VECTOR); ++b)
+				hash = (hash ^ bytes[b]) * 16777619u;
+			size_t slot = hash & (tableSize - 1);
+			while (table[slot] != ~0u && std::memcmp(&vertices[table[slot]].pos, &vertices[v].pos, sizeof(VECTOR)) != 0)
+				slot = (slot + 1) & (tableSize - 1);
+			if (table[slot] == ~0u) {
+				table[slot] = v;
+				positionOf[v] = count++;
+			}
+			else
+				positionOf[v] = positionOf[table[slot]];
+		}
+		return count;
+	}
+
+	// Simplifies one index range with quadric error metrics until it has at most targetIndexCount indices
+	// or no collapse under maxError is left. Returns the largest error introduced (model units).
+	// std::vector<unsigned>& indices - The range's triangles, replaced by the simplified ones
+	// const std::vector<unsigned>& positionOf - GetPositionIds of the whole vertex buffer
+	// size_t targetIndexCount - Stop once the range is this small
+	// float maxError - Largest allowed distance of a removed vertex from the surface, in model units
+	inline float SimplifyIndices(const VERTEX* vertices, const std::vector<unsigned>& positionOf, unsigned positionCount,
+		std::vector<unsigned>& indices, size_t targetIndexCount, float maxError)
+	{
+		auto position = [&](unsigned v) { return &vertices[v].pos.x; };
+		auto faceNormal = [](const float* a, const float* b, const float* c, double n[3]) {
+			double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+			n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+			n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+			return std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		};
+
+		// quadric of every position from the planes of its triangles
+		std::vector<QUADRIC> quadrics(positionCount);
+		for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+			double n[3];
+			const float* a = position(indices[t]);
+			double length = faceNormal(a, position(indices[t + 1]), position(indices[t + 2]), n);
+			if (length <= 0)
+				continue;
+			for (int k = 0; k < 3; ++k)
+				n[k] /= length;
+			double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+			for (int k = 0; k < 3; ++k)
+				quadrics[positionOf[indices[t + k]]].AddPlane(n, d);
+		}
+
+		// lock positions on open or non-manifold edges (range borders must stay where they are)
+		std::vector<char> locked(positionCount, 0);
+		{
+			std::unordered_map<uint64_t, unsigned> edgeUse;
+			edgeUse.reserve(indices.size());
+			auto key = [&](unsigned a, unsigned b) {
+				unsigned p = positionOf[a], q = positionOf[b];
+				return p < q ? (uint64_t(p) << 32 | q) : (uint64_t(q) << 32 | p);
+			};
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+				for (int k = 0; k < 3; ++k)
+					++edgeUse[key(indices[t + k], indices[t + (k + 1) % 3])];
+			for (auto& e : edgeUse)
+				if (e.second != 2) {
+					locked[e.first >> 32] = 1;
+					locked[e.first & 0xFFFFFFFFu] = 1;
+				}
+		}
+
+		float maxErrorSq = maxError * maxError;
+		double worstError = 0;
+		std::vector<unsigned> remap, touched(positionCount, 0), positionStart, positionTriangles, vertexStart, vertexTriangles;
+		unsigned pass = 0;
+		while (indices.size() > targetIndexCount) {
+			++pass;
+			size_t triangleCount = indices.size() / 3;
+			// position -> triangles & vertex -> triangles of the current triangles
+			unsigned vertexLimit = 0;
+			for (unsigned i : indices)
+				vertexLimit = std::max(vertexLimit, i + 1);
+			auto buildAdjacency = [&](std::vector<unsigned>& start, std::vector<unsigned>& list, size_t count, auto id) {
+				start.assign(count + 1, 0);
+				for (size_t i = 0; i < indices.size(); ++i)
+					++start[id(indices[i]) + 1];
+				for (size_t i = 0; i < count; ++i)
+					start[i + 1] += start[i];
+				list.resize(indices.size());
+				std::vector<unsigned> fill(start.begin(), start.end() - 1);
+				for (size_t i = 0; i < indices.size(); ++i)
+					list[fill[id(indices[i])]++] = static_cast<unsigned>(i / 3);
+			};
+			buildAdjacency(positionStart, positionTriangles, positionCount, [&](unsigned v) { return positionOf[v]; });
+			buildAdjacency(vertexStart, vertexTriangles, vertexLimit, [](unsigned v) { return v; });
+
+			// every edge as a collapse candidate in both directions, cheapest first
+			struct COLLAPSE {
+				unsigned from, to; // vertices (their positions are what collapses)
+				double cost;
+			};
+			std::vector<COLLAPSE> candidates;
+			candidates.reserve(indices.size() * 2);
+			for (size_t t = 0; t < triangleCount; ++t)
+				for (int k = 0; k < 3; ++k) {
+					unsigned a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+					if (positionOf[a] == positionOf[b])
+						continue;
+					if (!locked[positionOf[a]])
+						candidates.push_back(COLLAPSE{ a, b, quadrics[positionOf[a]].Evaluate(position(b)) });
+					if (!locked[positionOf[b]])
+						candidates.push_back(COLLAPSE{ b, a, quadrics[positionOf[b]].Evaluate(position(a)) });
+				}
+			std::sort(candidates.begin(), candidates.end(), [](const COLLAPSE& x, const COLLAPSE& y) { return x.cost < y.cost; });
+
+			remap.resize(vertexLimit);
+			for (unsigned v = 0; v < vertexLimit; ++v)
+				remap[v] = v;
+			size_t removedTriangles = 0, collapses = 0;
+			size_t wanted = (indices.size() - targetIndexCount) / 3;
+			std::vector<std::pair<unsigned, unsigned>> copyTargets;
+			for (const COLLAPSE& c : candidates) {
+				if (c.cost > maxErrorSq || removedTriangles >= wanted)
+					break;
+				unsigned p = positionOf[c.from], q = positionOf[c.to];
+				if (touched[p] == pass || touched[q] == pass)
+					continue;
+				// every copy of p must have an edge to a copy of q it can move onto (seams only collapse along themselves)
+				copyTargets.clear();
+				bool valid = true;
+				size_t shared = 0;
+				for (unsigned j = positionStart[p]; j < positionStart[p + 1] && valid; ++j) {
+					const unsigned* tri = &indices[positionTriangles[j] * 3];
+					bool hasQ = positionOf[tri[0]] == q || positionOf[tri[1]] == q || positionOf[tri[2]] == q;
+					shared += hasQ ? 1 : 0;
+					for (int k = 0; k < 3; ++k) {
+						if (positionOf[tri[k]] != p)
+							continue;
+						unsigned copy = tri[k], target = ~0u;
+						for (auto& known : copyTargets)
+							if (known.first == copy)
+								target = known.second;
+						if (target != ~0u)
+							continue;
+						for (unsigned m = vertexStart[copy]; m < vertexStart[copy + 1] && target == ~0u; ++m)
+							for (int n = 0; n < 3; ++n)
+								if (positionOf[indices[vertexTriangles[m] * 3 + n]] == q)
+									target = indices[vertexTriangles[m] * 3 + n];
+						if (target == ~0u)
+							valid = false;
+						else
+							copyTargets.push_back({ copy, target });
+					}
+					// the triangles that stay must not flip or collapse to a sliver
+					if (valid && !hasQ) {
+						const float* corner[3];
+						for (int k = 0; k < 3; ++k)
+							corner[k] = positionOf[tri[k]] == p ? position(c.to) : position(tri[k]);
+						double before[3], after[3];
+						double beforeLength = faceNormal(position(tri[0]), position(tri[1]), position(tri[2]), before);
+						double afterLength = faceNormal(corner[0], corner[1], corner[2], after);
+						double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+						if (afterLength <= 0 || dot <= 0.25 * beforeLength * afterLength)
+							valid = false;
+					}
+				}
+				if (!valid)
+					continue;
+				for (auto& known : copyTargets)
+					remap[known.first] = known.second;
+				quadrics[q].Add(quadrics[p]);
+				worstError = std::max(worstError, c.cost);
+				removedTriangles += shared;
+				++collapses;
+				// the neighbourhood changed, nothing around it may collapse again in this pass
+				for (unsigned j = positionStart[p]; j < positionStart[p + 1]; ++j)
+					for (int k = 0; k < 3; ++k)
+						touched[positionOf[indices[positionTriangles[j] * 3 + k]]] = pass;
+			}
+			if (collapses == 0)
+				break;
+
+			// apply & drop the triangles that became degenerate
+			size_t write = 0;
+			for (size_t t = 0; t < triangleCount; ++t) {
+				unsigned a = remap[indices[t * 3]], b = remap[indices[t * 3 + 1]], c = remap[indices[t * 3 + 2]];
+				if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c])
+					continue;
+				indices[write++] = a;
+				indices[write++] = b;
+				indices[write++] = c;
+			}
+			indices.resize(write);
+		}
+		return static_cast<float>(std::sqrt(worstError));
+	}
+
+	// What BuildLodChain produces for each level, for logs and the cook report
+	struct LOD_REPORT {
+		unsigned triangleCount;
+		float error; // model units
+		float relativeError; // error / size of the mesh bounds
+	};
+
+	// Builds up to lodCount simplified levels of a whole file, each about half the triangles of the one before
+	// A level that can't get 10% smaller within the error budget ends the chain.
+	// float maxRelativeError - Error budget of the coarsest level as a fraction of the mesh bounds (finer levels get less)
+	// Returns the number of levels built
+	inline unsigned BuildLodChain(const VERTEX* vertices, unsigned vertexCount, const unsigned* indices, unsigned indexCount,
+		const std::vector<BATCH>& batches, const std::vector<MESH>& meshes, LOD_CHAIN& chain, std::vector<LOD_REPORT>* report = nullptr,
+		unsigned lodCount = 3, float maxRelativeError = 0.05f)
+	{
+		chain = LOD_CHAIN();
+		for (unsigned i = 0; i < indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return 0;
+		std::vector<unsigned> positionOf;
+		unsigned positionCount = GetPositionIds(vertices, vertexCount, positionOf);
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (unsigned v = 0; v < vertexCount; ++v)
+			for (int k = 0; k < 3; ++k) {
+				minimum[k] = std::min(minimum[k], (&vertices[v].pos.x)[k]);
+				maximum[k] = std::max(maximum[k], (&vertices[v].pos.x)[k]);
+			}
+		float extent = 0;
+		for (int k = 0; k < 3; ++k)
+			extent = std::max(extent, maximum[k] - minimum[k]);
+		if (extent <= 0)
+			return 0;
+
+		// split the file at every BATCH & MESH boundary, each piece is simplified on its own
+		std::vector<unsigned> bounds = { 0, indexCount };
+		auto add = [&](const BATCH& b) {
+			if (b.indexOffset <= indexCount && b.indexCount <= indexCount - b.indexOffset) {
+				bounds.push_back(b.indexOffset);
+				bounds.push_back(b.indexOffset + b.indexCount);
+			}
+		};
+		for (auto& b : batches)
+			add(b);
+		for (auto& m : meshes)
+			add(m.drawInfo);
+		std::sort(bounds.begin(), bounds.end());
+		bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+		std::vector<std::vector<unsigned>> pieces(bounds.size() - 1);
+		for (size_t i = 0; i + 1 < bounds.size(); ++i)
+			pieces[i].assign(indices + bounds[i], indices + bounds[i + 1]);
+
+		unsigned previousTriangles = indexCount / 3;
+		float previousError = 0;
+		for (unsigned lod = 1; lod <= lodCount; ++lod) {
+			float errorBudget = maxRelativeError * extent * static_cast<float>(lod) / static_cast<float>(lodCount);
+			float levelError = previousError; // each level is simplified from the one before
+			std::vector<size_t> pieceStart(pieces.size() + 1, 0);
+			std::vector<unsigned> levelIndices;
+			for (size_t i = 0; i < pieces.size(); ++i) {
+				if (pieces[i].size() % 3 == 0 && pieces[i].size() >= 6)
+					levelError = std::max(levelError, SimplifyIndices(vertices, positionOf, positionCount, pieces[i],
+						(pieces[i].size() / 6) * 3, errorBudget));
+				pieceStart[i] = levelIndices.size();
+				levelIndices.insert(levelIndices.end(), pieces[i].begin(), pieces[i].end());
+			}
+			pieceStart[pieces.size()] = levelIndices.size();
+			unsigned triangles = static_cast<unsigned>(levelIndices.size() / 3);
+			if (triangles * 10 > previousTriangles * 9)
+				break;
+			previousTriangles = triangles;
+			previousError = levelError;
+
+			// each mesh draws the pieces between its boundaries
+			unsigned base = static_cast<unsigned>(chain.indices.size());
+			for (auto& m : meshes) {
+				BATCH draw = { 0, base };
+				auto first = std::lower_bound(bounds.begin(), bounds.end(), m.drawInfo.indexOffset);
+				auto last = std::lower_bound(bounds.begin(), bounds.end(), m.drawInfo.indexOffset + m.drawInfo.indexCount);
+				if (first != bounds.end() && last != bounds.end() && *first == m.drawInfo.indexOffset) {
+					draw.indexOffset = base + static_cast<unsigned>(pieceStart[first - bounds.begin()]);
+					draw.indexCount = static_cast<unsigned>(pieceStart[last - bounds.begin()] - pieceStart[first - bounds.begin()]);
+				}
+				chain.draws.push_back(draw);
+			}
+			chain.indices.insert(chain.indices.end(), levelIndices.begin(), levelIndices.end());
+			chain.levels.push_back(LOD_INFO{ levelError, triangles, { 0, 0 } });
+			if (report)
+				report->push_back(LOD_REPORT{ triangles, levelError, levelError / extent });
+		}
+		return static_cast<unsigned>(chain.levels.size());
+	}
+
+	// Packs a LOD chain into a SECTION_LODS v2 section
+	inline EXTRA_SECTION MakeLodSection(const LOD_CHAIN& chain, unsigned meshCount)
+	{
+		LOD_HEADER header = { static_cast<unsigned>(chain.levels.size()), meshCount, static_cast<unsigned>(chain.indices.size()), 0 };
+		EXTRA_SECTION section{ SECTION_LODS, {} };
+		auto append = [&](const void* data, size_t size) {
+			section.data.insert(section.data.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+		};
+		append(&header, sizeof(header));
+		append(chain.levels.data(), sizeof(LOD_INFO) * chain.levels.size());
+		append(chain.draws.data(), sizeof(BATCH) * chain.draws.size());
+		append(chain.indices.data(), sizeof(unsigned) * chain.indices.size());
+		return section;
+	}
+
+	// Reads a SECTION_LODS section, false if it is malformed or doesn't fit the file
+	inline bool ReadLodSection(const char* data, size_t size, unsigned vertexCount, unsigned meshCount, LOD_CHAIN& chain)
+	{
+		chain = LOD_CHAIN();
+		LOD_HEADER header;
+		if (data == nullptr || size < sizeof(header))
+			return false;
+		std::memcpy(&header, data, sizeof(header));
+		size_t expected = sizeof(header) + sizeof(LOD_INFO) * size_t(header.lodCount) +
+			sizeof(BATCH) * size_t(header.lodCount) * header.meshCount + sizeof(unsigned) * size_t(header.indexCount);
+		if (header.meshCount != meshCount || header.lodCount > 16 || size != expected)
+			return false;
+		const char* cursor = data + sizeof(header);
+		chain.levels.resize(header.lodCount);
+		std::memcpy(chain.levels.data(), cursor, sizeof(LOD_INFO) * chain.levels.size());
+		cursor += sizeof(LOD_INFO) * chain.levels.size();
+		chain.draws.resize(size_t(header.lodCount) * header.meshCount);
+		std::memcpy(chain.draws.data(), cursor, sizeof(BATCH) * chain.draws.size());
+		cursor += sizeof(BATCH) * chain.draws.size();
+		chain.indices.resize(header.indexCount);
+		std::memcpy(chain.indices.data(), cursor, sizeof(unsigned) * chain.indices.size());
+		bool valid = true;
+		for (auto& d : chain.draws)
+			valid = valid && d.indexOffset <= header.indexCount && d.indexCount <= header.indexCount - d.indexOffset;
+		for (unsigned i : chain.indices)
+			valid = valid && i < vertexCount;
+		if (!valid)
+			chain = LOD_CHAIN();
+		return valid;
+	}
+}
+#endif
@@ -0,0 +1,366 @@
+#ifndef _H2BSTREAMPARSER_H_
+#define _H2BSTREAMPARSER_H_
+// Push style .h2b parsing: the file is fed in chunks of any size as they arrive (async reads, network...) and each part
+// of the result can be used as soon as its bytes are in, so decoding and GPU uploads can overlap the remaining I/O.
+// "019d" files are decoded as the bytes arrive. v2 containers are buffered, their vertex & index sections are handed
+// out as soon as they are complete and the tables are decoded once the last section is in.
+// The finished result is the same H2B::Parser that Parser::Parse produces.
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "h2bParser.h"
+
+namespace H2B {
+
+	// Parts of a file a StreamParser can hand out, as bit flags
+	enum STREAM_PART : unsigned {
+		STREAM_HEADER = 1 << 0, // version & counts
+		STREAM_VERTICES = 1 << 1,
+		STREAM_INDICES = 1 << 2,
+		STREAM_MATERIALS = 1 << 3,
+		STREAM_BATCHES = 1 << 4,
+		STREAM_MESHES = 1 << 5,
+		STREAM_COMPLETE = 1 << 6, // everything, including bounds & optional v2 sections
+	};
+
+	class StreamParser
+	{
+		// where the decoder is in a "019d" file
+		enum STAGE { STAGE_VERSION, STAGE_COUNTS, STAGE_VERTICES, STAGE_INDICES, STAGE_MATERIAL, STAGE_MATERIAL_NAME,
+			STAGE_BATCHES, STAGE_MESH_NAME, STAGE_MESH_DRAW, STAGE_V2, STAGE_DONE, STAGE_FAILED };
+		Parser result;
+		STAGE stage = STAGE_VERSION;
+		unsigned available = 0;
+		size_t filled = 0; // bytes of the current fixed size field received so far
+		unsigned item = 0, name = 0; // material/mesh being decoded & which of its names
+		std::string pending; // name received so far
+		char counts[16];
+		char meshDraw[12];
+		// v2: the whole file so far, and where it ends once the section table is known (0 until then)
+		std::vector<char> buffer;
+		size_t fileSize = 0;
+
+		//Copies up to "total - filled" bytes into dest, true once all "total" bytes are in
+		bool Fill(const char*& data, size_t& size, void* dest, size_t total) {
+			size_t count = std::min(size, total - filled);
+			if (count > 0)
+				std::memcpy(static_cast<char*>(dest) + filled, data, count);
+			filled += count;
+			data += count;
+			size -= count;
+			if (filled < total)
+				return false;
+			filled = 0;
+			return true;
+		}
+		//Collects a '\0' terminated name into "pending", true once the terminator is in
+		bool FillString(const char*& data, size_t& size) {
+			const char* end = static_cast<const char*>(std::memchr(data, '\0', size));
+			size_t count = end ? size_t(end - data) : size;
+			pending.append(data, count);
+			data += count;
+			size -= count;
+			if (end == nullptr)
+				return false;
+			++data;
+			--size;
+			return true;
+		}
+		//Interns the collected name like Parse does (nullptr for empty names)
+		const char* TakeName() {
+			const char* stored = pending.empty() ? nullptr : result.file_strings.Intern(pending.c_str());
+			pending.clear();
+			return stored;
+		}
+		//Marks parts as available & adds them to the flags returned by Feed
+		void Publish(unsigned parts, unsigned& ready) {
+			available |= parts;
+			ready |= parts;
+		}
+		//Moves past the parts of a "019d" file that have no entries
+		void SkipEmpty(unsigned& ready) {
+			if (stage == STAGE_MATERIAL && item == result.materialCount) {
+				Publish(STREAM_MATERIALS, ready);
+				stage = STAGE_BATCHES;
+			}
+			if (stage == STAGE_BATCHES && result.materialCount == 0) {
+				Publish(STREAM_BATCHES, ready);
+				stage = STAGE_MESH_NAME;
+				item = 0;
+			}
+			if (stage == STAGE_MESH_NAME && item == result.meshCount)
+				Complete(ready);
+		}
+		//Finishes a file whose every byte is in
+		void Complete(unsigned& ready) {
+			ComputeFileBounds(result.vertices.data(), result.vertexCount, result.indices.data(), result.indexCount,
+				result.meshes, result.bounds, result.meshBounds);
+			stage = STAGE_DONE;
+			Publish(STREAM_MESHES | STREAM_COMPLETE, ready);
+		}
+		//Buffers v2 bytes, handing out the geometry sections as they complete and decoding the rest at the end
+		void FeedV2(const char*& data, size_t& size, unsigned& ready) {
+			size_t take = fileSize ? std::min(size, fileSize - buffer.size()) : size;
+			buffer.insert(buffer.end(), data, data + take);
+			data += take;
+			size -= take;
+			if (fileSize == 0) {
+				// the section table tells where the file ends
+				HEADER_V2 header;
+				if (buffer.size() < sizeof(header))
+					return;
+				std::memcpy(&header, buffer.data(), sizeof(header));
+				if (header.headerSize < sizeof(header) || header.sectionCount > (1u << 16)) {
+					stage = STAGE_FAILED;
+					return;
+				}
+				size_t tableEnd = size_t(header.headerSize) + sizeof(SECTION_V2) * header.sectionCount;
+				if (buffer.size() < tableEnd)
+					return;
+				fileSize = tableEnd;
+				for (unsigned i = 0; i < header.sectionCount; ++i) {
+					SECTION_V2 section;
+					std::memcpy(&section, buffer.data() + header.headerSize + sizeof(SECTION_V2) * i, sizeof(section));
+					fileSize = std::max(fileSize, size_t(section.offset) + section.size);
+				}
+				std::memcpy(result.version, header.magic, 4);
+				result.vertexCount = header.vertexCount;
+				result.indexCount = header.indexCount;
+				result.materialCount = header.materialCount;
+				result.meshCount = header.meshCount;
+				Publish(STREAM_HEADER, ready);
+				// bytes past the end of the file are left to the caller
+				if (buffer.size() > fileSize) {
+					size_t extra = buffer.size() - fileSize;
+					data -= extra;
+					size += extra;
+					buffer.resize(fileSize);
+				}
+				buffer.reserve(fileSize);
+			}
+			// geometry sections, as soon as their bytes are in
+			auto geometry = [&](unsigned type, size_t expectedSize, STREAM_PART part, void* dest) {
+				if (available & part)
+					return;
+				const SECTION_V2* found = FindSectionV2(buffer.data(), fileSize, type);
+				if (found == nullptr || found->size != expectedSize || found->offset % SECTION_ALIGNMENT != 0) {
+					stage = STAGE_FAILED;
+					return;
+				}
+				if (buffer.size() >= size_t(found->offset) + found->size) {
+					std::memcpy(dest, buffer.data() + found->offset, found->size);
+					Publish(part, ready);
+				}
+			};
+			// FindSectionV2 only needs the header & table, which are in, so it is given the final size
+			if (!(available & STREAM_VERTICES))
+				result.vertices.resize(result.vertexCount);
+			if (!(available & STREAM_INDICES))
+				result.indices.resize(result.indexCount);
+			geometry(SECTION_VERTICES, sizeof(VERTEX) * size_t(result.vertexCount), STREAM_VERTICES, result.vertices.data());
+			if (stage != STAGE_FAILED)
+				geometry(SECTION_INDICES, sizeof(unsigned) * size_t(result.indexCount), STREAM_INDICES, result.indices.data());
+			if (stage == STAGE_FAILED || buffer.size() < fileSize)
+				return;
+
+			const char* vertexData = nullptr;
+			const char* indexData = nullptr;
+			auto storeName = [this](const char* name) { return result.file_strings.Intern(name); };
+			if (!DecodeV2(buffer.data(), buffer.size(), result.version, result.vertexCount, result.indexCount, result.materialCount,
+				result.meshCount, vertexData, indexData, result.materials, result.batches, result.meshes, storeName)) {
+				stage = STAGE_FAILED;
+				return;
+			}
+			CopyExtraSectionsV2(buffer.data(), buffer.size(), result.extraSections);
+			std::vector<char>().swap(buffer);
+			Publish(STREAM_MATERIALS | STREAM_BATCHES, ready);
+			Complete(ready);
+		}
+
+	public:
+		StreamParser() {
+			Reset();
+		}
+
+		//Forgets everything fed so far, ready for a new file
+		void Reset() {
+			result.Clear();
+			stage = STAGE_VERSION;
+			available = 0;
+			filled = 0;
+			item = name = 0;
+			pending.clear();
+			std::vector<char>().swap(buffer);
+			fileSize = 0;
+		}
+
+		//Decodes the next bytes of the file, chunks may be any size (even split inside a value or name)
+		//Returns the STREAM_PART flags that became available during this call (0 when none did or after a failure)
+		//const void* data - The next bytes
+		//size_t size - The number of bytes, bytes after the end of the file are ignored
+		unsigned Feed(const void* data, size_t size) {
+			unsigned ready = 0;
+			const char* bytes = static_cast<const char*>(data);
+			while (size > 0 && stage != STAGE_DONE && stage != STAGE_FAILED) {
+				switch (stage) {
+				case STAGE_VERSION:
+					if (!Fill(bytes, size, result.version, 4))
+						break;
+					if (!IsSupportedVersion(result.version)) {
+						stage = STAGE_FAILED;
+						break;
+					}
+					if (IsVersion2(result.version)) {
+						buffer.assign(result.version, result.version + 4);
+						stage = STAGE_V2;
+					}
+					else
+						stage = STAGE_COUNTS;
+					break;
+				case STAGE_COUNTS:
+					if (!Fill(bytes, size, counts, sizeof(counts)))
+						break;
+					std::memcpy(&result.vertexCount, counts, 4);
+					std::memcpy(&result.indexCount, counts + 4, 4);
+					std::memcpy(&result.materialCount, counts + 8, 4);
+					std::memcpy(&result.meshCount, counts + 12, 4);
+					result.vertices.resize(result.vertexCount);
+					result.indices.resize(result.indexCount);
+					result.materials.resize(result.materialCount);
+					result.batches.resize(result.materialCount);
+					result.meshes.resize(result.meshCount);
+					Publish(STREAM_HEADER, ready);
+					stage = STAGE_VERTICES;
+					break;
+				case STAGE_VERTICES:
+					if (!Fill(bytes, size, result.vertices.data(), sizeof(VERTEX) * size_t(result.vertexCount)))
+						break;
+					Publish(STREAM_VERTICES, ready);
+					stage = STAGE_INDICES;
+					break;
+				case STAGE_INDICES:
+					if (!Fill(bytes, size, result.indices.data(), sizeof(unsigned) * size_t(result.indexCount)))
+						break;
+					Publish(STREAM_INDICES, ready);
+					stage = STAGE_MATERIAL;
+					item = 0;
+					break;
+				case STAGE_MATERIAL:
+					if (!Fill(bytes, size, &result.materials[item].attrib, 80))
+						break;
+					stage = STAGE_MATERIAL_NAME;
+					name = 0;
+					break;
+				case STAGE_MATERIAL_NAME:
+					if (!FillString(bytes, size))
+						break;
+					*((&result.materials[item].name) + name) = TakeName();
+					if (++name == 10) {
+						++item;
+						stage = STAGE_MATERIAL;
+					}
+					break;
+				case STAGE_BATCHES:
+					if (!Fill(bytes, size, result.batches.data(), sizeof(BATCH) * size_t(result.materialCount)))
+						break;
+					Publish(STREAM_BATCHES, ready);
+					stage = STAGE_MESH_NAME;
+					item = 0;
+					break;
+				case STAGE_MESH_NAME:
+					if (!FillString(bytes, size))
+						break;
+					result.meshes[item].name = TakeName();
+					stage = STAGE_MESH_DRAW;
+					break;
+				case STAGE_MESH_DRAW:
+					if (!Fill(bytes, size, meshDraw, sizeof(meshDraw)))
+						break;
+					std::memcpy(&result.meshes[item].drawInfo, meshDraw, 8);
+					std::memcpy(&result.meshes[item].materialIndex, meshDraw + 8, 4);
+					++item;
+					stage = STAGE_MESH_NAME;
+					break;
+				case STAGE_V2:
+					FeedV2(bytes, size, ready);
+					break;
+				default:
+					break;
+				}
+				// a "019d" file without materials or meshes is complete right after its indices
+				if (stage == STAGE_MATERIAL || stage == STAGE_BATCHES || stage == STAGE_MESH_NAME)
+					SkipEmpty(ready);
+			}
+			return stage == STAGE_FAILED ? 0 : ready;
+		}
+
+		//Tells the parser the input has ended, returns true if the whole file was decoded
+		bool Finish() {
+			if (stage != STAGE_DONE)
+				stage = STAGE_FAILED;
+			return stage == STAGE_DONE;
+		}
+
+		//Returns the STREAM_PART flags of every part decoded so far
+		inline unsigned Available() const {
+			return stage == STAGE_FAILED ? 0 : available;
+		}
+
+		//Returns true once every part of the file was decoded
+		inline bool IsComplete() const {
+			return stage == STAGE_DONE;
+		}
+
+		//Returns true if the data was not a valid .h2b file (or ended early after Finish)
+		inline bool Failed() const {
+			return stage == STAGE_FAILED;
+		}
+
+		//Returns the file decoded so far, only the parts flagged by Available() hold valid data
+		inline const Parser& GetResult() const {
+			return result;
+		}
+
+		//Moves the decoded file out (the parser is Reset afterwards)
+		//Parser& out - Receives the result, names keep pointing into its own storage
+		void TakeResult(Parser& out) {
+			out = std::move(result);
+			Reset();
+		}
+	};
+
+	// Parses a .h2b file by reading it in chunks and feeding them to a StreamParser
+	// const char* h2bPath - The file to read
+	// Parser& out - Receives the result, identical to Parser::Parse
+	// size_t chunkSize - Bytes per read
+	// OnParts onParts - Called as onParts(unsigned newParts, const Parser& partial) whenever parts become available
+	template <typename OnParts>
+	bool ParseInChunks(const char* h2bPath, Parser& out, size_t chunkSize, OnParts onParts)
+	{
+		std::ifstream file(h2bPath, std::ios_base::in | std::ios_base::binary);
+		if (!file.is_open() || chunkSize == 0)
+			return false;
+		StreamParser stream;
+		std::unique_ptr<char[]> chunk(new char[chunkSize]);
+		while (!stream.IsComplete() && !stream.Failed()) {
+			file.read(chunk.get(), static_cast<std::streamsize>(chunkSize));
+			size_t read = static_cast<size_t>(file.gcount());
+			if (read == 0)
+				break;
+			unsigned parts = stream.Feed(chunk.get(), read);
+			if (parts != 0)
+				onParts(parts, stream.GetResult());
+		}
+		if (!stream.Finish())
+			return false;
+		stream.TakeResult(out);
+		return true;
+	}
+	inline bool ParseInChunks(const char* h2bPath, Parser& out, size_t chunkSize = 64 * 1024)
+	{
+		return ParseInChunks(h2bPath, out, chunkSize, [](unsigned, const Parser&) {});
+	}
+}
+#endif
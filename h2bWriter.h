@@ -0,0 +1,149 @@
+#ifndef _H2BWRITER_H_
+#define _H2BWRITER_H_
+// Writes parsed .h2b data back to disk, either as the original "019d" layout or as an H2B v2 container.
+// Used by the offline conversion/cook tools, the game itself only reads.
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "h2bParser.h"
+
+namespace H2B {
+
+	// Everything a .h2b file holds, as plain pointers so it can come from a Parser, a MappedParser or a tool
+	struct FILE_DATA {
+		const VERTEX* vertices = nullptr;
+		unsigned vertexCount = 0;
+		const unsigned* indices = nullptr;
+		unsigned indexCount = 0;
+		const MATERIAL* materials = nullptr;
+		const BATCH* batches = nullptr; // one per material
+		unsigned materialCount = 0;
+		const MESH* meshes = nullptr;
+		unsigned meshCount = 0;
+	};
+
+	inline FILE_DATA GetFileData(const Parser& parser) {
+		return FILE_DATA{ parser.vertices.data(), parser.vertexCount, parser.indices.data(), parser.indexCount,
+			parser.materials.data(), parser.batches.data(), parser.materialCount, parser.meshes.data(), parser.meshCount };
+	}
+	inline FILE_DATA GetFileData(const MappedParser& parser) {
+		return FILE_DATA{ parser.vertices, parser.vertexCount, parser.indices, parser.indexCount,
+			parser.materials.data(), parser.batches.data(), parser.materialCount, parser.meshes.data(), parser.meshCount };
+	}
+
+	// Writes "data" in the original sequential "019d" layout
+	inline bool WriteV1(const char* h2bPath, const FILE_DATA& data)
+	{
+		std::ofstream file(h2bPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (file.is_open() == false)
+			return false;
+		auto writeString = [&](const char* str) {
+			if (str)
+				file.write(str, std::strlen(str));
+			file.put('\0');
+		};
+		file.write("019d", 4);
+		file.write(reinterpret_cast<const char*>(&data.vertexCount), 4);
+		file.write(reinterpret_cast<const char*>(&data.indexCount), 4);
+		file.write(reinterpret_cast<const char*>(&data.materialCount), 4);
+		file.write(reinterpret_cast<const char*>(&data.meshCount), 4);
+		file.write(reinterpret_cast<const char*>(data.vertices), sizeof(VERTEX) * size_t(data.vertexCount));
+		file.write(reinterpret_cast<const char*>(data.indices), sizeof(unsigned) * size_t(data.indexCount));
+		for (unsigned i = 0; i < data.materialCount; ++i) {
+			file.write(reinterpret_cast<const char*>(&data.materials[i].attrib), 80);
+			for (int j = 0; j < 10; ++j)
+				writeString(*((&data.materials[i].name) + j));
+		}
+		file.write(reinterpret_cast<const char*>(data.batches), sizeof(BATCH) * size_t(data.materialCount));
+		for (unsigned i = 0; i < data.meshCount; ++i) {
+			writeString(data.meshes[i].name);
+			file.write(reinterpret_cast<const char*>(&data.meshes[i].drawInfo), 8);
+			file.write(reinterpret_cast<const char*>(&data.meshes[i].materialIndex), 4);
+		}
+		return file.good();
+	}
+
+	// Writes "data" as an H2B v2 container with 16 byte aligned sections
+	// const std::vector<EXTRA_SECTION>& extras - Optional sections written after the standard ones
+	inline bool WriteV2(const char* h2bPath, const FILE_DATA& data, const std::vector<EXTRA_SECTION>& extras = {})
+	{
+		// string table, every distinct name stored once
+		std::vector<char> strings;
+		std::unordered_map<std::string, unsigned> stringOffsets;
+		auto addString = [&](const char* str) -> unsigned {
+			if (str == nullptr)
+				return NO_STRING;
+			auto found = stringOffsets.find(str);
+			if (found != stringOffsets.end())
+				return found->second;
+			unsigned offset = static_cast<unsigned>(strings.size());
+			strings.insert(strings.end(), str, str + std::strlen(str) + 1);
+			stringOffsets.emplace(str, offset);
+			return offset;
+		};
+		std::vector<MATERIAL_V2> materials(data.materialCount);
+		for (unsigned i = 0; i < data.materialCount; ++i) {
+			materials[i].attrib = data.materials[i].attrib;
+			for (int j = 0; j < 10; ++j)
+				materials[i].names[j] = addString(*((&data.materials[i].name) + j));
+		}
+		std::vector<MESH_V2> meshes(data.meshCount);
+		for (unsigned i = 0; i < data.meshCount; ++i) {
+			meshes[i].name = addString(data.meshes[i].name);
+			meshes[i].drawInfo = data.meshes[i].drawInfo;
+			meshes[i].materialIndex = data.meshes[i].materialIndex;
+		}
+
+		struct PAYLOAD {
+			unsigned type;
+			const void* data;
+			size_t size;
+		};
+		std::vector<PAYLOAD> payloads = {
+			{ SECTION_VERTICES, data.vertices, sizeof(VERTEX) * size_t(data.vertexCount) },
+			{ SECTION_INDICES, data.indices, sizeof(unsigned) * size_t(data.indexCount) },
+			{ SECTION_MATERIALS, materials.data(), sizeof(MATERIAL_V2) * materials.size() },
+			{ SECTION_BATCHES, data.batches, sizeof(BATCH) * size_t(data.materialCount) },
+			{ SECTION_MESHES, meshes.data(), sizeof(MESH_V2) * meshes.size() },
+			{ SECTION_STRINGS, strings.data(), strings.size() },
+		};
+		for (auto& e : extras)
+			payloads.push_back({ e.type, e.data.data(), e.data.size() });
+
+		auto align = [](size_t offset) { return (offset + SECTION_ALIGNMENT - 1) & ~size_t(SECTION_ALIGNMENT - 1); };
+		HEADER_V2 header = {};
+		std::memcpy(header.magic, "H2B2", 4);
+		header.headerSize = sizeof(HEADER_V2);
+		header.vertexCount = data.vertexCount;
+		header.indexCount = data.indexCount;
+		header.materialCount = data.materialCount;
+		header.meshCount = data.meshCount;
+		header.sectionCount = static_cast<unsigned>(payloads.size());
+		std::vector<SECTION_V2> sections(payloads.size());
+		size_t offset = align(sizeof(HEADER_V2) + sizeof(SECTION_V2) * sections.size());
+		for (size_t i = 0; i < payloads.size(); ++i) {
+			if (offset + payloads[i].size > 0xFFFFFFFFull)
+				return false; // offsets are 32 bit
+			sections[i] = SECTION_V2{ payloads[i].type, static_cast<unsigned>(offset), static_cast<unsigned>(payloads[i].size), 0 };
+			offset = align(offset + payloads[i].size);
+		}
+
+		std::ofstream file(h2bPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (file.is_open() == false)
+			return false;
+		const char zeros[SECTION_ALIGNMENT] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(HEADER_V2));
+		file.write(reinterpret_cast<const char*>(sections.data()), sizeof(SECTION_V2) * sections.size());
+		size_t written = sizeof(HEADER_V2) + sizeof(SECTION_V2) * sections.size();
+		for (size_t i = 0; i < payloads.size(); ++i) {
+			file.write(zeros, sections[i].offset - written);
+			if (payloads[i].size)
+				file.write(static_cast<const char*>(payloads[i].data), payloads[i].size);
+			written = sections[i].offset + payloads[i].size;
+		}
+		file.write(zeros, align(written) - written);
+		return file.good();
+	}
+}
+#endif
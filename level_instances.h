@@ -0,0 +1,133 @@
+// The models of a level in structure of arrays form.
+// Every MESH block of the GameLevel is an instance, index i of each array below belongs to instance i, so the passes
+// RenderLevel makes over the whole level every frame (culling, UBO packing) walk contiguous memory and only read the
+// fields they use. The parsed .h2b data stays in the MeshResources (mesh_cache.h), instances only hold an index to one.
+#ifndef _LEVEL_INSTANCES_H_
+#define _LEVEL_INSTANCES_H_
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// Shared CPU & GPU data of each .h2b
+#include "mesh_cache.h"
+// Frustum tests
+#include "cluster_culling.h"
+
+// Per instance state bits
+enum INSTANCE_FLAGS : unsigned char {
+	INSTANCE_VISIBLE = 1, // inside the frustum of the last Cull
+	INSTANCE_MIRRORED = 2, // the world matrix flips the winding (or is flat), backfaces can't be culled in model space
+};
+
+class LevelInstances {
+	// mesh -> index in meshes, so every instance of a mesh shares one entry
+	std::unordered_map<const MeshResource*, unsigned> meshIndexOf;
+
+	// Recomputes the world space bounds & mirrored flag of one instance from its world matrix
+	void UpdateBounds(size_t i) {
+		const MeshResource& mesh = *meshes[meshIndices[i]];
+		const float* world = worlds[i].data;
+		worldBounds[i] = H2B::TransformBounds(mesh.GetBounds(), world);
+		const std::vector<H2B::BOUNDS>& meshBounds = mesh.GetMeshBounds();
+		H2B::BOUNDS* parts = &partBounds[firstParts[i]];
+		// meshes without their own bounds get the whole instance's
+		for (unsigned p = 0; p < partCounts[i]; ++p)
+			parts[p] = p < meshBounds.size() ? H2B::TransformBounds(meshBounds[p], world) : worldBounds[i];
+		float determinant = world[0] * (world[5] * world[10] - world[6] * world[9]) + world[1] * (world[6] * world[8] - world[4] * world[10]) +
+			world[2] * (world[4] * world[9] - world[5] * world[8]);
+		flags[i] = determinant > 0 ? (flags[i] & ~INSTANCE_MIRRORED) : (flags[i] | INSTANCE_MIRRORED);
+	}
+
+public:
+	// Hot, read every frame
+	std::vector<GW::MATH::GMATRIXF> worlds;
+	std::vector<H2B::BOUNDS> worldBounds; // the whole instance, world space
+	std::vector<unsigned> meshIndices; // into meshes
+	std::vector<unsigned> firstParts; // the instance's H2B::MESHes (one material each) are partBounds[firstParts[i]...]
+	std::vector<unsigned> partCounts;
+	std::vector<unsigned> triangleCounts; // full detail triangles, for RENDER_STATS
+	std::vector<unsigned char> flags; // INSTANCE_FLAGS
+	// World space bounds of each instance's H2B::MESHes, instance after instance
+	std::vector<H2B::BOUNDS> partBounds;
+	// Cold, read while loading & debugging
+	std::vector<std::string> names;
+	// Each mesh the instances draw, once
+	std::vector<std::shared_ptr<MeshResource>> meshes;
+
+	//Adds an instance at the end
+	//Returns its index
+	//const char* name - Name in the GameLevel (useful for debugging)
+	//const float* world - 4x4 row major world matrix
+	//std::shared_ptr<MeshResource> mesh - Mesh handed out by the level's MeshCache
+	size_t Add(const char* name, const float* world, std::shared_ptr<MeshResource> mesh) {
+		auto found = meshIndexOf.emplace(mesh.get(), static_cast<unsigned>(meshes.size()));
+		if (found.second)
+			meshes.push_back(std::move(mesh));
+		const MeshResource& resource = *meshes[found.first->second];
+		unsigned triangles = 0;
+		for (const H2B::MESH& m : resource.GetMeshes())
+			triangles += m.drawInfo.indexCount / 3;
+		GW::MATH::GMATRIXF matrix;
+		std::memcpy(matrix.data, world, sizeof(matrix.data));
+		size_t i = worlds.size();
+		worlds.push_back(matrix);
+		worldBounds.push_back(H2B::BOUNDS());
+		meshIndices.push_back(found.first->second);
+		firstParts.push_back(static_cast<unsigned>(partBounds.size()));
+		partCounts.push_back(static_cast<unsigned>(resource.GetMeshes().size()));
+		triangleCounts.push_back(triangles);
+		flags.push_back(0);
+		partBounds.resize(partBounds.size() + partCounts.back());
+		names.push_back(name);
+		UpdateBounds(i);
+		return i;
+	}
+
+	//Moves an instance, its world bounds follow
+	//size_t i - Index returned by Add
+	//const GW::MATH::GMATRIXF& world - New world matrix
+	void SetWorldMatrix(size_t i, const GW::MATH::GMATRIXF& world) {
+		worlds[i] = world;
+		UpdateBounds(i);
+	}
+
+	//Marks the instances whose world bounds touch a frustum INSTANCE_VISIBLE and clears the bit on the rest, one pass over worldBounds
+	//Returns the number of visible instances
+	//const FRUSTUM* frustum - World space frustum, nullptr marks every instance visible
+	size_t Cull(const FRUSTUM* frustum) {
+		size_t visible = 0;
+		for (size_t i = 0; i < worldBounds.size(); ++i) {
+			bool inside = frustum == nullptr || SphereInFrustum(*frustum, worldBounds[i].center, worldBounds[i].radius);
+			flags[i] = inside ? (flags[i] | INSTANCE_VISIBLE) : (flags[i] & ~INSTANCE_VISIBLE);
+			visible += inside ? 1 : 0;
+		}
+		return visible;
+	}
+
+	//Returns the number of instances
+	inline size_t Size() const {
+		return worlds.size();
+	}
+
+	//Exchanges every instance with another LevelInstances
+	void Swap(LevelInstances& other) {
+		meshIndexOf.swap(other.meshIndexOf);
+		worlds.swap(other.worlds);
+		worldBounds.swap(other.worldBounds);
+		meshIndices.swap(other.meshIndices);
+		firstParts.swap(other.firstParts);
+		partCounts.swap(other.partCounts);
+		triangleCounts.swap(other.triangleCounts);
+		flags.swap(other.flags);
+		partBounds.swap(other.partBounds);
+		names.swap(other.names);
+		meshes.swap(other.meshes);
+	}
+
+	//Removes every instance and lets go of their meshes
+	void Clear() {
+		LevelInstances empty;
+		Swap(empty);
+	}
+};
+#endif
@@ -0,0 +1,267 @@
+// Switches levels without stalling the frame: the next level is parsed on a background thread into a second
+// Level_Objects, uploaded to the GPU a slice per frame, then swapped with the level on screen between two frames.
+// Levels switched away from (or prefetched) stay resident, CPU & GPU data included, while they fit the residency
+// limits (see SetResidency), least recently used first out. Switching to a resident level is a swap, nothing is loaded.
+// Include after load_object_oriented.h (and Gateware).
+#ifndef _LEVEL_SWITCHER_H_
+#define _LEVEL_SWITCHER_H_
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+class LevelSwitcher {
+	// IDLE -> LOADING (background thread) -> UPLOADING (GL thread, a slice per Update) -> IDLE (swapped in or made resident)
+	enum STATE { IDLE, LOADING, UPLOADING };
+	STATE state = IDLE;
+	// where the next level is loaded and uploaded
+	Level_Objects staging;
+	// result of the background LoadLevel
+	std::future<bool> loading;
+	struct REQUEST {
+		std::string gameLevelPath;
+		std::string h2bFolderPath;
+		AsyncLog log;
+	};
+	// level being loaded, and the newest one asked for meanwhile (started once the current load is done)
+	REQUEST current;
+	REQUEST queued;
+	bool hasQueued = false;
+	// the current load only warms the cache instead of going on screen (Prefetch, or a newer Request came in)
+	bool prefetching = false;
+
+	// GameLevel.txt of the level on screen
+	std::string onScreenPath;
+	// A loaded level that is not on screen
+	struct RESIDENT {
+		std::string gameLevelPath;
+		std::unique_ptr<Level_Objects> level;
+		size_t cpuBytes;
+		size_t gpuBytes;
+	};
+	// most recently used first
+	std::list<RESIDENT> residents;
+	// residency limits, nothing is kept by default
+	size_t maxResidentLevels = 0;
+	size_t cpuByteBudget = 0;
+	size_t gpuByteBudget = 0;
+	// levels Prefetch won't load again (already prefetched once or failed) until they are requested
+	std::unordered_set<std::string> skipPrefetch;
+
+	// Starts loading a level on a background thread, with the same load settings as the level on screen
+	void Start(const REQUEST& request, const Level_Objects& level, bool prefetch) {
+		staging.UnloadLevel(); // GL resources are freed here, on the GL thread, never in the background
+		staging.CopyLoadSettings(level);
+		current = request;
+		prefetching = prefetch;
+		state = LOADING;
+		loading = std::async(std::launch::async, [this, request] {
+			return staging.LoadLevel(request.gameLevelPath.c_str(), request.h2bFolderPath.c_str(), request.log);
+		});
+	}
+
+	// Returns the resident copy of a level, residents.end() if there is none
+	std::list<RESIDENT>::iterator FindResident(const std::string& gameLevelPath) {
+		for (auto it = residents.begin(); it != residents.end(); ++it)
+			if (it->gameLevelPath == gameLevelPath)
+				return it;
+		return residents.end();
+	}
+
+	// Moves a loaded level out of "from" into a new most recently used resident, then applies the limits
+	void MakeResident(const std::string& gameLevelPath, Level_Objects& from) {
+		if (gameLevelPath.empty()) {
+			from.UnloadLevel();
+			return;
+		}
+		RESIDENT resident = { gameLevelPath, std::make_unique<Level_Objects>(), 0, 0 };
+		resident.level->SwapLevel(from);
+		resident.level->GetMemoryUsage(resident.cpuBytes, resident.gpuBytes);
+		residents.push_front(std::move(resident));
+		Evict();
+	}
+
+	// Frees least recently used residents until the rest fit the level count and both byte budgets
+	void Evict() {
+		for (;;) {
+			size_t cpuBytes = 0, gpuBytes = 0;
+			for (auto& r : residents) {
+				cpuBytes += r.cpuBytes;
+				gpuBytes += r.gpuBytes;
+			}
+			if (residents.empty() || (residents.size() <= maxResidentLevels && cpuBytes <= cpuByteBudget && gpuBytes <= gpuByteBudget))
+				return;
+			residents.back().level->UnloadLevel();
+			residents.pop_back();
+		}
+	}
+
+	// Puts a resident level on screen, the level that was there takes its place as the most recently used resident
+	void SwapIn(std::list<RESIDENT>::iterator resident, Level_Objects& level) {
+		level.SwapLevel(*resident->level);
+		std::string previous = onScreenPath;
+		onScreenPath = resident->gameLevelPath;
+		residents.splice(residents.begin(), residents, resident);
+		if (previous.empty()) {
+			residents.front().level->UnloadLevel();
+			residents.pop_front();
+			return;
+		}
+		resident->gameLevelPath = previous;
+		resident->level->GetMemoryUsage(resident->cpuBytes, resident->gpuBytes);
+		Evict();
+	}
+
+public:
+	//Waits for a background load, then frees the staging & resident levels
+	~LevelSwitcher() {
+		if (loading.valid())
+			loading.wait();
+		staging.UnloadLevel();
+		for (auto& r : residents)
+			r.level->UnloadLevel();
+	}
+
+	//Chooses how many levels stay loaded after being switched away from, and how much memory they may hold together
+	//size_t levels - Most levels kept besides the one on screen, 0 frees a level as soon as it leaves the screen
+	//size_t cpuBytes - RAM the kept levels may hold together
+	//size_t gpuBytes - VRAM the kept levels may hold together
+	void SetResidency(size_t levels, size_t cpuBytes, size_t gpuBytes) {
+		maxResidentLevels = levels;
+		cpuByteBudget = cpuBytes;
+		gpuByteBudget = gpuBytes;
+		Evict();
+	}
+
+	//Tells the switcher which level is on screen when it was loaded without it (the first level, a synchronous switch)
+	//const char* gameLevelPath - GameLevel.txt of the level on screen
+	void SetOnScreen(const char* gameLevelPath) {
+		onScreenPath = gameLevelPath;
+	}
+
+	//Asks for a level to be put on screen
+	//A resident level is swapped in right away, any other is loaded in the background while the current level keeps
+	//drawing (see Update). Asking while another level loads queues the request, the older load becomes a prefetch.
+	//Returns true if the level was swapped in right away
+	//const char* gameLevelPath - GameLevel.txt of the new level
+	//const char* h2bFolderPath - Folder its .h2b files are in
+	//Level_Objects& level - The level on screen, its load settings are used
+	//AsyncLog log - Receives the load messages (written from the loading thread)
+	bool Request(const char* gameLevelPath, const char* h2bFolderPath, Level_Objects& level, AsyncLog log) {
+		REQUEST request = { gameLevelPath, h2bFolderPath, log };
+		skipPrefetch.erase(request.gameLevelPath);
+		if (state != IDLE && request.gameLevelPath == current.gameLevelPath) {
+			// already on its way, show it when it is ready
+			prefetching = false;
+			hasQueued = false;
+			return false;
+		}
+		if (state != IDLE)
+			prefetching = true;
+		if (request.gameLevelPath == onScreenPath) {
+			hasQueued = false;
+			return false;
+		}
+		auto resident = FindResident(request.gameLevelPath);
+		if (resident != residents.end()) {
+			hasQueued = false;
+			SwapIn(resident, level);
+			return true;
+		}
+		if (state != IDLE) {
+			queued = request;
+			hasQueued = true;
+			return false;
+		}
+		Start(request, level, false);
+		return false;
+	}
+
+	//Loads a level in the background and keeps it resident without putting it on screen, so a later Request is instant
+	//Does nothing while busy, or for a level that is on screen, resident, or was prefetched (or failed to load) before
+	//Returns true if the level started loading
+	bool Prefetch(const char* gameLevelPath, const char* h2bFolderPath, const Level_Objects& level, AsyncLog log) {
+		REQUEST request = { gameLevelPath, h2bFolderPath, log };
+		if (state != IDLE || maxResidentLevels == 0 || request.gameLevelPath == onScreenPath ||
+			FindResident(request.gameLevelPath) != residents.end() || skipPrefetch.count(request.gameLevelPath))
+			return false;
+		skipPrefetch.insert(request.gameLevelPath);
+		Start(request, level, true);
+		return true;
+	}
+
+	//Moves a requested or prefetched level along, call once a frame on the GL thread
+	//Returns true on the frame a level was swapped into "level"
+	//Level_Objects& level - The level on screen
+	//size_t uploadByteBudget - About how many bytes of the new level to upload this frame
+	bool Update(Level_Objects& level, size_t uploadByteBudget) {
+		bool swapped = false;
+		if (state == LOADING) {
+			if (loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return false;
+			if (loading.get())
+				state = UPLOADING;
+			else {
+				// keep drawing the current level, LoadLevel already logged why
+				skipPrefetch.insert(current.gameLevelPath);
+				staging.UnloadLevel();
+				state = IDLE;
+			}
+		}
+		if (state == UPLOADING) {
+			if (!staging.UploadLevelToGPU(uploadByteBudget))
+				return false;
+			if (prefetching)
+				MakeResident(current.gameLevelPath, staging);
+			else {
+				level.SwapLevel(staging);
+				MakeResident(onScreenPath, staging); // the old level, kept while it fits
+				onScreenPath = current.gameLevelPath;
+				swapped = true;
+			}
+			state = IDLE;
+		}
+		if (state == IDLE && hasQueued) {
+			hasQueued = false;
+			swapped = Request(queued.gameLevelPath.c_str(), queued.h2bFolderPath.c_str(), level, queued.log) || swapped;
+		}
+		return swapped;
+	}
+
+	//Returns true while a requested or prefetched level is loading or uploading
+	inline bool IsBusy() const {
+		return state != IDLE;
+	}
+
+	//Returns true while a requested level is on its way to the screen (not counting prefetches)
+	inline bool IsSwitching() const {
+		return (state != IDLE && !prefetching) || hasQueued;
+	}
+
+	//Returns the GameLevel.txt of the level on its way to the screen (the last one loaded when idle)
+	inline const std::string& GetLoadingPath() const {
+		return hasQueued ? queued.gameLevelPath : current.gameLevelPath;
+	}
+
+	//Returns the GameLevel.txt of the level on screen
+	inline const std::string& GetOnScreenPath() const {
+		return onScreenPath;
+	}
+
+	//Returns the number of levels kept loaded besides the one on screen
+	inline size_t GetResidentCount() const {
+		return residents.size();
+	}
+
+	//Adds up the RAM & VRAM held by the resident levels
+	void GetResidentMemory(size_t& cpuBytes, size_t& gpuBytes) const {
+		cpuBytes = gpuBytes = 0;
+		for (auto& r : residents) {
+			cpuBytes += r.cpuBytes;
+			gpuBytes += r.gpuBytes;
+		}
+	}
+};
+#endif
@@ -0,0 +1,229 @@
+// Lights of a level for clustered forward shading.
+// The LIGHT blocks of a GameLevel become GPU_LIGHTs (directional lights first), and every frame LightGrid cuts the view
+// frustum into froxels (screen tiles x depth slices growing exponentially with distance) and lists which point & spot
+// lights reach each one, so a fragment only shades the lights of its froxel. Directional lights reach every fragment.
+// The exporter only writes a name and a matrix per light: the type comes from Blender's default names ("Sun", "Spot",
+// "Point", "Area", "Light"...), lights shine down their matrix's third row, and color & range come from LIGHT_DEFAULTS.
+#ifndef _LIGHT_GRID_H_
+#define _LIGHT_GRID_H_
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "game_level_parser.h"
+
+// One light as the shaders read it (std430 "Lights" buffer)
+struct GPU_LIGHT {
+	float position[4]; // xyz world position, w range (0 for directional lights)
+	float color[4]; // rgb color * intensity
+	float direction[4]; // xyz direction the light shines in, w cosine of the spot cone (-1 lights every direction)
+};
+
+// What the exporter doesn't write about lights
+struct LIGHT_DEFAULTS {
+	float pointColor[3] = { 1.0f, 0.9f, 0.7f };
+	float pointRange = 8.0f; // distance at which point & spot lights fade out completely
+	float spotCosine = 0.7071f; // cosine of half the spot cone (45 degrees)
+	float sunColor[3] = { 0.9f, 0.9f, 1.0f };
+	// used when a level has no directional light
+	bool addSun = true;
+	float sunDirection[3] = { -0.4082f, -0.4082f, -0.8165f };
+};
+
+//Returns true if a light's name starts with a type name, ignoring case (Blender names "Sun.001", "Spot_Hall"...)
+inline bool LightNameIs(const char* name, const char* type)
+{
+	for (; *type; ++name, ++type)
+		if (std::tolower(static_cast<unsigned char>(*name)) != *type)
+			return false;
+	return true;
+}
+
+//Turns the LIGHT blocks of a level into GPU_LIGHTs, directional lights first
+//Returns the number of directional lights
+//const std::vector<LEVEL_OBJECT>& lights - GameLevelParser::lights
+//std::vector<GPU_LIGHT>& out - Receives the lights
+inline unsigned BuildLights(const std::vector<LEVEL_OBJECT>& lights, const LIGHT_DEFAULTS& defaults, std::vector<GPU_LIGHT>& out)
+{
+	out.clear();
+	std::vector<GPU_LIGHT> local;
+	auto setDirection = [](GPU_LIGHT& light, const float* d, float cosine) {
+		float length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		for (int k = 0; k < 3; ++k)
+			light.direction[k] = length > 0 ? d[k] / length : (k == 1 ? -1.0f : 0.0f);
+		light.direction[3] = cosine;
+	};
+	for (const LEVEL_OBJECT& object : lights) {
+		GPU_LIGHT light = {};
+		bool sun = LightNameIs(object.name, "sun");
+		bool spot = LightNameIs(object.name, "spot");
+		setDirection(light, object.world + 8, spot ? defaults.spotCosine : -1.0f);
+		const float* color = sun ? defaults.sunColor : defaults.pointColor;
+		for (int k = 0; k < 3; ++k) {
+			light.position[k] = object.world[12 + k];
+			light.color[k] = color[k];
+		}
+		light.position[3] = sun ? 0.0f : defaults.pointRange;
+		(sun ? out : local).push_back(light);
+	}
+	if (out.empty() && defaults.addSun) {
+		GPU_LIGHT light = {};
+		setDirection(light, defaults.sunDirection, -1.0f);
+		std::memcpy(light.color, defaults.sunColor, sizeof(defaults.sunColor));
+		out.push_back(light);
+	}
+	unsigned directionalCount = static_cast<unsigned>(out.size());
+	out.insert(out.end(), local.begin(), local.end());
+	return directionalCount;
+}
+
+class LightGrid {
+	unsigned tilesX = 16, tilesY = 9, slices = 24;
+	// (froxel, light) pairs of the current Build, sorted into lightIndices by froxel
+	std::vector<unsigned> pairFroxels;
+	std::vector<unsigned> pairLights;
+	// depth of each slice boundary, and view x (y) per unit of depth of each tile boundary
+	std::vector<float> sliceDepths;
+	std::vector<float> tileSlopesX;
+	std::vector<float> tileSlopesY;
+
+public:
+	// Grid layout as the shaders read it (std430 "LightClusters" buffer, followed by one CLUSTER per froxel)
+	struct HEADER {
+		unsigned grid[4]; // tiles x, tiles y, depth slices, directional light count
+		float depth[4]; // slice = floor(log(view depth) * x + y), z near, w far
+		float viewport[4]; // x, y, 1 / width, 1 / height (pixels)
+	};
+	struct CLUSTER {
+		unsigned offset; // into lightIndices
+		unsigned count;
+	};
+	HEADER header = {};
+	// froxel x + tilesX * (y + tilesY * slice)
+	std::vector<CLUSTER> clusters;
+	// point & spot lights of each froxel, indices into the light list
+	std::vector<unsigned> lightIndices;
+
+	//Chooses how finely the frustum is cut, 1 x 1 x 1 lists every light for every fragment
+	//unsigned x, y - Screen tiles across & down
+	//unsigned z - Depth slices between the near & far planes
+	void SetGridSize(unsigned x, unsigned y, unsigned z) {
+		tilesX = std::max(1u, x);
+		tilesY = std::max(1u, y);
+		slices = std::max(1u, z);
+	}
+
+	//Lists the lights reaching each froxel of a view
+	//const std::vector<GPU_LIGHT>& lights - From BuildLights, the first directionalCount are directional
+	//const float* view - Row major view matrix, nullptr puts every light in one froxel (no view to cut)
+	//const float* projection - Row major OpenGL perspective projection
+	//const int* viewport - x, y, width & height in pixels
+	void Build(const std::vector<GPU_LIGHT>& lights, unsigned directionalCount, const float* view, const float* projection, const int* viewport) {
+		bool cut = view != nullptr && projection != nullptr && projection[11] != 0;
+		unsigned nx = cut ? tilesX : 1, ny = cut ? tilesY : 1, nz = cut ? slices : 1;
+		float zNear = 0.1f, zFar = 100.0f;
+		if (cut) {
+			zNear = projection[14] / (projection[10] - 1.0f);
+			zFar = projection[14] / (projection[10] + 1.0f);
+			if (!(zNear > 0 && zFar > zNear)) {
+				zNear = 0.1f;
+				zFar = 100.0f;
+			}
+		}
+		float logRatio = std::log(zFar / zNear);
+		header = HEADER{ { nx, ny, nz, directionalCount },
+			{ nz / logRatio, -(nz * std::log(zNear)) / logRatio, zNear, zFar },
+			{ float(viewport[0]), float(viewport[1]), 1.0f / std::max(1, viewport[2]), 1.0f / std::max(1, viewport[3]) } };
+		clusters.assign(size_t(nx) * ny * nz, CLUSTER{ 0, 0 });
+		pairFroxels.clear();
+		pairLights.clear();
+		sliceDepths.resize(nz + 1);
+		for (unsigned k = 0; k <= nz; ++k)
+			sliceDepths[k] = zNear * std::exp(logRatio * k / nz);
+		tileSlopesX.resize(nx + 1);
+		tileSlopesY.resize(ny + 1);
+		for (unsigned x = 0; x <= nx && cut; ++x)
+			tileSlopesX[x] = (2.0f * x / nx - 1.0f) / projection[0];
+		for (unsigned y = 0; y <= ny && cut; ++y)
+			tileSlopesY[y] = (2.0f * y / ny - 1.0f) / projection[5];
+		for (unsigned l = directionalCount; l < lights.size(); ++l) {
+			const GPU_LIGHT& light = lights[l];
+			if (!cut) {
+				pairFroxels.push_back(0);
+				pairLights.push_back(l);
+				continue;
+			}
+			// sphere of the light in view space, the camera looks down -z
+			float c[3];
+			for (int k = 0; k < 3; ++k)
+				c[k] = light.position[0] * view[0 * 4 + k] + light.position[1] * view[1 * 4 + k] + light.position[2] * view[2 * 4 + k] + view[12 + k];
+			float r = light.position[3], depth = -c[2];
+			if (depth + r < zNear || depth - r > zFar)
+				continue;
+			unsigned k0 = 0, k1 = nz - 1;
+			if (depth - r > zNear)
+				k0 = std::min(nz - 1, static_cast<unsigned>(std::log((depth - r) / zNear) * header.depth[0]));
+			if (depth + r < zFar)
+				k1 = std::min(nz - 1, static_cast<unsigned>(std::log((depth + r) / zNear) * header.depth[0]));
+			// screen rectangle of the sphere's box, the whole screen when it reaches behind the near plane
+			unsigned x0 = 0, x1 = nx - 1, y0 = 0, y1 = ny - 1;
+			if (depth - r > zNear) {
+				auto tile = [](float ndc, unsigned count) {
+					return static_cast<unsigned>(std::min(float(count - 1), std::max(0.0f, (ndc * 0.5f + 0.5f) * count)));
+				};
+				float nearDepth = depth - r, farDepth = depth + r;
+				float ndc[4] = {
+					std::min((c[0] - r) / nearDepth, (c[0] - r) / farDepth) * projection[0],
+					std::max((c[0] + r) / nearDepth, (c[0] + r) / farDepth) * projection[0],
+					std::min((c[1] - r) / nearDepth, (c[1] - r) / farDepth) * projection[5],
+					std::max((c[1] + r) / nearDepth, (c[1] + r) / farDepth) * projection[5] };
+				if (ndc[1] < -1 || ndc[0] > 1 || ndc[3] < -1 || ndc[2] > 1)
+					continue;
+				x0 = tile(ndc[0], nx);
+				x1 = tile(ndc[1], nx);
+				y0 = tile(ndc[2], ny);
+				y1 = tile(ndc[3], ny);
+			}
+			// the sphere against the box around each froxel of that range
+			for (unsigned k = k0; k <= k1; ++k) {
+				float d0 = sliceDepths[k], d1 = sliceDepths[k + 1];
+				float dz = std::max(0.0f, std::max(d0 - depth, depth - d1));
+				float rz = r * r - dz * dz;
+				if (rz < 0)
+					continue;
+				for (unsigned y = y0; y <= y1; ++y) {
+					float minY = std::min(tileSlopesY[y] * d0, tileSlopesY[y] * d1), maxY = std::max(tileSlopesY[y + 1] * d0, tileSlopesY[y + 1] * d1);
+					float dy = std::max(0.0f, std::max(minY - c[1], c[1] - maxY));
+					float ry = rz - dy * dy;
+					if (ry < 0)
+						continue;
+					for (unsigned x = x0; x <= x1; ++x) {
+						// the froxel's box around both of its depths, the sphere must reach it
+						float minX = std::min(tileSlopesX[x] * d0, tileSlopesX[x] * d1), maxX = std::max(tileSlopesX[x + 1] * d0, tileSlopesX[x + 1] * d1);
+						float dx = std::max(0.0f, std::max(minX - c[0], c[0] - maxX));
+						if (dx * dx > ry)
+							continue;
+						pairFroxels.push_back(x + nx * (y + ny * k));
+						pairLights.push_back(l);
+					}
+				}
+			}
+		}
+		// counting sort of the pairs by froxel
+		for (unsigned f : pairFroxels)
+			++clusters[f].count;
+		unsigned offset = 0;
+		for (CLUSTER& cluster : clusters) {
+			cluster.offset = offset;
+			offset += cluster.count;
+			cluster.count = 0;
+		}
+		lightIndices.resize(pairLights.size());
+		for (size_t p = 0; p < pairLights.size(); ++p) {
+			CLUSTER& cluster = clusters[pairFroxels[p]];
+			lightIndices[cluster.offset + cluster.count++] = pairLights[p];
+		}
+	}
+};
+#endif
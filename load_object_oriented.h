@@ -3,293 +3,686 @@
 
 // This reads .h2b files which are optimized binary .obj+.mtl files
 #include "h2bParser.h"
+// Shares one parsed & uploaded copy of each .h2b between all Models using it
+#include "mesh_cache.h"
+// Frustum & backface culling of meshlets
+#include "cluster_culling.h"
+// Single pass GameLevel.txt reader
+#include "game_level_parser.h"
+// Compiled GameLevel files
+#include "h2bScene.h"
+// Matches GameLevel names to the .h2b files of the model folder
+#include "asset_resolver.h"
+// The level's models as parallel arrays
+#include "level_instances.h"
+// LIGHT blocks & the clustered light grid
+#include "light_grid.h"
+// Lock-free logging from the loading threads
+#include "async_log.h"
+// Parent / child transforms of the models
+#include "transform_hierarchy.h"
+
+// What the last RenderLevel submitted
+struct RENDER_STATS {
+	size_t totalTriangles = 0; // triangles of every drawn model
+	size_t drawnTriangles = 0; // triangles left after culling
+	size_t drawCalls = 0;
+	size_t lights = 0; // lights of the level, directional ones included
+	size_t lightAssignments = 0; // point & spot lights listed in froxels, summed over the froxels
+	size_t transformsUpdated = 0; // world matrices recomputed because a model (or its parent) moved
+};
 
-class Model {
-	// Name of the Model in the GameLevel (useful for debugging)
-	std::string name;
-	// Loads and stores CPU model data from .h2b file
-	H2B::Parser cpuModel; // reads the .h2b format
-	// Shader variables needed by this model. 
-	GW::MATH::GMATRIXF world;
-	// TODO: Add matrix/light/etc vars..
-	// TODO: API Rendering vars here (unique to this model)
-	
-	// Vertex Buffer
-	GLuint vertexArray = 0;
-	GLuint vertexBufferObject = 0;
-	// Index Buffer
-	GLuint indexBufferObject = 0;
-	// Pipeline/State Objects
-	GLuint locShaderMats = 0;
-	// Uniform/ShaderVariable Buffer
-	GLuint UBO = 0;
-
-	//Model Data Struct
+class Level_Objects {
+
+	// store all our models (one instance per MESH block, see level_instances.h)
+	LevelInstances instances;
+	// local & world matrix of each instance (node i is instance i), models only move through it
+	TransformHierarchy transforms;
+	// every block of the level's GameLevel.txt (the models are made from its MESH blocks)
+	GameLevelParser levelFile;
+	// .h2b files of the model folder, indexed once per LoadLevel
+	AssetResolver modelFiles;
+	// LoadLevel reads GameLevel.h2l instead of GameLevel.txt when it is at least as new
+	bool useCompiledScenes = false;
+	// every unique .h2b of the level, parsed & uploaded once
+	MeshCache meshCache;
+	// Shader variables of one draw (UBO #2 "ModelData")
 	struct MODEL_DATA {
 		GW::MATH::GMATRIXF worldMatrix; //Final world space transform
 		H2B::ATTRIBUTES material; //Color/texture of surface
-		// TODO: Add matrix/light/etc vars..
-		// TODO: API Rendering vars here (unique to this model)
+		GW::MATH::GVECTORF positionOffset; //Compact vertices: position = offset + stored * scale (0 for float vertices)
+		GW::MATH::GVECTORF positionScale; //Compact vertices: size of the mesh bounds (1 for float vertices)
+		GW::MATH::GVECTORF uvTransform; //Compact vertices: uv offset (xy) & scale (zw)
+		unsigned int vertexFormat[4]; //x: 0 = 36 byte float vertices, 1 = 16 byte compact vertices
+	};
+	// One H2B::MESH of a visible instance: drawRanges[firstRange...] with the MODEL_DATA packed at its own index
+	struct DRAW {
+		unsigned mesh; // index into instances.meshes
+		unsigned firstRange;
+		unsigned rangeCount;
 	};
-	//Model Object
-	MODEL_DATA model;
+	// what the last RenderLevel drew, rebuilt every call
+	std::vector<DRAW> draws;
+	std::vector<H2B::BATCH> drawRanges;
+	// MODEL_DATA of every draw, modelDataStride bytes apart, uploaded to modelUBO in one call
+	std::vector<char> modelData;
+	// sizeof(MODEL_DATA) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	size_t modelDataStride = 0;
+	// uniform buffer each draw binds its MODEL_DATA range of
+	GLuint modelUBO = 0;
+	// the level's lights, directional ones first (see light_grid.h)
+	std::vector<GPU_LIGHT> lights;
+	unsigned directionalLights = 0;
+	// what the exporter doesn't say about lights
+	LIGHT_DEFAULTS lightDefaults;
+	// froxels of the view being drawn & the lights reaching each, rebuilt every RenderLevel
+	LightGrid lightGrid;
+	unsigned lightGridSize[3] = { 16, 9, 24 };
+	// shader storage buffers: lights (binding 3), grid header & froxels (4), light indices of the froxels (5)
+	GLuint lightBuffer = 0;
+	GLuint clusterBuffer = 0;
+	GLuint lightIndexBuffer = 0;
+	// meshes are welded & reordered for the vertex cache, overdraw, meshlets and vertex fetch while loading (their before/after stats get logged)
+	bool optimizeOnLoad = false;
+	// 0 -> draw every meshlet, 1 -> frustum culling, 2 -> frustum & backface cone culling
+	int clusterCulling = 0;
+	// largest on screen error (pixels) a simplified level may have, 0 always draws full detail
+	float lodPixelError = 0;
+	// what the last RenderLevel submitted
+	RENDER_STATS renderStats;
+	// threads LoadLevel parses .h2b files on (0 -> one per hardware thread, 1 -> only the calling thread)
+	unsigned loadThreads = 0;
+	// workers for loadThreads, created by the first LoadLevel that needs them
+	std::unique_ptr<ThreadPool> loadPool;
+
+	// Returns the pool LoadLevel parses on, nullptr when loading on the calling thread only
+	ThreadPool* GetLoadPool() {
+		if (loadThreads == 1)
+			return nullptr;
+		if (!loadPool)
+			loadPool = std::make_unique<ThreadPool>(loadThreads == 0 ? 0 : loadThreads - 1);
+		return loadPool.get();
+	}
 
-public:
-	//Sets the name of the model to modelName
-	//std::string modelName - New name for the model
-	inline void SetName(std::string modelName) {
-		name = modelName;
+	// Returns true if the compiled scene exists and isn't older than its GameLevel.txt (or the text is gone)
+	static bool IsSceneCurrent(const char* gameLevelPath, const std::string& scenePath) {
+		std::error_code error;
+		auto sceneTime = std::filesystem::last_write_time(scenePath, error);
+		if (error)
+			return false;
+		auto textTime = std::filesystem::last_write_time(gameLevelPath, error);
+		return error || sceneTime >= textTime;
 	}
 
-	//Sets the world matrix of the model to worldMatrix
-	//GW::MATH::GMATRIXF worldMatrix - New world matrix for the model
-	inline void SetWorldMatrix(GW::MATH::GMATRIXF worldMatrix) {
-		world = worldMatrix;
+	// Returns the size of a file for a LoadTimer, 0 without a trace (the disk isn't asked)
+	static size_t TracedFileSize(const LoadTrace* trace, const std::string& path) {
+		std::error_code error;
+		size_t size = trace ? static_cast<size_t>(std::filesystem::file_size(path, error)) : 0;
+		return error ? 0 : size;
 	}
 
-	bool LoadModelDataFromDisk(const char* h2bPath) {
-		// if this succeeds "cpuModel" should now contain all the model's info
-		return cpuModel.Parse(h2bPath);
+	// Returns the number of threads LoadLevel parses on, the calling thread included
+	unsigned GetLoadThreadCount() {
+		ThreadPool* pool = GetLoadPool();
+		return pool ? pool->GetThreadCount() + 1 : 1;
 	}
 
-	bool UploadModelData2GPU() {
-		//EVERYTHING THATS DONE ONCE PER CYCLE
+	// Fills a CULL_VIEW with an instance's frustum & camera position in model space
+	void GetCullView(size_t i, const float* viewProjection, const float* cameraPos, const CULL_VIEW& settings, CULL_VIEW& view) const {
+		const float* world = instances.worlds[i].data;
+		float clip[16];
+		MultiplyMatrix4(world, viewProjection, clip);
+		view.frustum = ExtractFrustum(clip);
+		view.cullFrustum = settings.cullFrustum;
+		view.lodErrorPerDistance = settings.lodErrorPerDistance;
+		// a mirroring world matrix flips which side is the front, leave those to the rasterizer
+		view.cullBackfaces = settings.cullBackfaces && !(instances.flags[i] & INSTANCE_MIRRORED);
+		// a flat world matrix has no model space camera to measure distance from
+		if (InverseTransformPoint(world, cameraPos, view.camera) == 0)
+			view.lodErrorPerDistance = 0;
+	}
 
-		//Create a Vertex Buffer
-		CreateVertexBuffer(cpuModel.vertices.data(), (sizeof(H2B::VERTEX) * cpuModel.vertexCount), vertexArray, vertexBufferObject);
+	// Returns the simplified level of a mesh to draw from a model space view, 0 for full detail
+	static unsigned SelectLod(const MeshResource& mesh, const CULL_VIEW& view) {
+		if (view.lodErrorPerDistance <= 0 || mesh.GetLodCount() == 0)
+			return 0;
+		const H2B::BOUNDS& bounds = mesh.GetBounds();
+		float d[3] = { bounds.center[0] - view.camera[0], bounds.center[1] - view.camera[1], bounds.center[2] - view.camera[2] };
+		float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - bounds.radius;
+		// the coarsest level whose error still stays under the limit from the closest point of the bounds
+		for (unsigned lod = mesh.GetLodCount(); lod > 0 && distance > 0; --lod)
+			if (mesh.GetLodError(lod) <= view.lodErrorPerDistance * distance)
+				return lod;
+		return 0;
+	}
 
-		//Create an Index Buffer
-		CreateIndexBuffer(cpuModel.indices.data(), (sizeof(unsigned int) * cpuModel.indexCount), indexBufferObject);
+	// Adds what is left of one H2B::MESH after culling to drawRanges, neighbouring visible meshlets become one range
+	void AddVisibleRanges(const MeshResource& mesh, size_t part, unsigned lod, const CULL_VIEW* view) {
+		const std::vector<H2B::MESHLET>& meshlets = mesh.GetMeshlets();
+		const std::vector<H2B::MESHLET_RANGE>& meshletRanges = mesh.GetMeshletRanges();
+		if (lod > 0)
+			drawRanges.push_back(mesh.GetLodDraw(lod, part)); // simplified levels are too small on screen to be worth culling
+		else if (view == nullptr || part >= meshletRanges.size() || meshletRanges[part].count == 0)
+			drawRanges.push_back(mesh.GetMeshes()[part].drawInfo);
+		else {
+			size_t first = drawRanges.size();
+			for (unsigned m = meshletRanges[part].first; m < meshletRanges[part].first + meshletRanges[part].count; ++m) {
+				if (!MeshletVisible(meshlets[m], *view))
+					continue;
+				if (drawRanges.size() > first && drawRanges.back().indexOffset + drawRanges.back().indexCount == meshlets[m].indexOffset)
+					drawRanges.back().indexCount += meshlets[m].indexCount;
+				else
+					drawRanges.push_back(H2B::BATCH{ meshlets[m].indexCount, meshlets[m].indexOffset });
+			}
+		}
+	}
 
-		//Create UBO Buffer
-		CreateUBO(&model, sizeof(MODEL_DATA), UBO);
+	// Lists the lights of each froxel of the view being drawn and binds the light buffers
+	// const float* view, projection - nullptr lists every light everywhere
+	void UploadLightGrid(const float* view, const float* projection) {
+		if (lightBuffer == 0)
+			return;
+		GLint viewport[4] = { 0, 0, 1, 1 };
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		lightGrid.SetGridSize(lightGridSize[0], lightGridSize[1], lightGridSize[2]);
+		lightGrid.Build(lights, directionalLights, view, projection, viewport);
+		//Header & froxels in one buffer, a new store each time so the last view's draws aren't waited on
+		size_t clusterBytes = sizeof(LightGrid::CLUSTER) * lightGrid.clusters.size();
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightGrid::HEADER) + clusterBytes, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(LightGrid::HEADER), &lightGrid.header);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(LightGrid::HEADER), clusterBytes, lightGrid.clusters.data());
+		//Buffers bound to shaders can't be empty
+		const unsigned noIndex = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(1, lightGrid.lightIndices.size()) * sizeof(unsigned),
+			lightGrid.lightIndices.empty() ? &noIndex : lightGrid.lightIndices.data(), GL_STREAM_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lightBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, clusterBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, lightIndexBuffer);
+	}
 
-		//Establish Vertex Attribute Information
-		SetVertexAttributes();
+	// Adds the lights of the last light grid to renderStats
+	void AddLightStats() {
+		renderStats.lights = lights.size();
+		renderStats.lightAssignments = lightGrid.lightIndices.size();
+	}
 
-		return true;
+	// Culls & draws the level in three linear passes: whole instances against the frustum, then the visible ones' meshes
+	// & meshlets into draws with their MODEL_DATA packed side by side, then one upload and a glBindBufferRange per draw
+	// const CULL_VIEW* settings - nullptr draws everything at full detail, viewProjection & cameraPos are unused then
+	void Render(GLuint shaderExecutable, const CULL_VIEW* settings, const float* viewProjection, const float* cameraPos) {
+		renderStats = RENDER_STATS();
+		renderStats.transformsUpdated = UpdateTransforms();
+		draws.clear();
+		drawRanges.clear();
+		modelData.clear();
+		if (modelUBO == 0)
+			return;
+		FRUSTUM frustum;
+		bool cullFrustum = settings && settings->cullFrustum;
+		if (cullFrustum)
+			frustum = ExtractFrustum(viewProjection);
+		instances.Cull(cullFrustum ? &frustum : nullptr);
+
+		MODEL_DATA model = {};
+		CULL_VIEW view;
+		for (size_t i = 0; i < instances.Size(); ++i) {
+			renderStats.totalTriangles += instances.triangleCounts[i];
+			if (!(instances.flags[i] & INSTANCE_VISIBLE))
+				continue;
+			unsigned meshIndex = instances.meshIndices[i];
+			const MeshResource& mesh = *instances.meshes[meshIndex];
+			if (!mesh.IsUploaded())
+				continue;
+			if (settings)
+				GetCullView(i, viewProjection, cameraPos, *settings, view);
+			unsigned lod = settings ? SelectLod(mesh, view) : 0;
+			//Tell the vertex shader where the model is and how to decode this mesh's vertices
+			model.worldMatrix = instances.worlds[i];
+			const H2B::QUANTIZATION& quantization = mesh.GetQuantization();
+			std::memcpy(&model.positionOffset, quantization.positionOffset, sizeof(GW::MATH::GVECTORF));
+			std::memcpy(&model.positionScale, quantization.positionScale, sizeof(GW::MATH::GVECTORF));
+			std::memcpy(&model.uvTransform, quantization.uvTransform, sizeof(GW::MATH::GVECTORF));
+			model.vertexFormat[0] = mesh.UsesCompactVertices() ? 1 : 0;
+
+			const std::vector<H2B::MESH>& meshes = mesh.GetMeshes();
+			const std::vector<H2B::MATERIAL>& materials = mesh.GetMaterials();
+			const H2B::BOUNDS* parts = &instances.partBounds[instances.firstParts[i]];
+			for (unsigned p = 0; p < instances.partCounts[i]; ++p) {
+				//Skip meshes completely outside the frustum
+				if (cullFrustum && !SphereInFrustum(frustum, parts[p].center, parts[p].radius))
+					continue;
+				size_t firstRange = drawRanges.size();
+				AddVisibleRanges(mesh, p, lod, settings ? &view : nullptr);
+				if (drawRanges.size() == firstRange || drawRanges[firstRange].indexCount == 0) {
+					drawRanges.resize(firstRange);
+					continue;
+				}
+				//Copy the parsed model material onto the model
+				model.material = materials[meshes[p].materialIndex].attrib;
+				modelData.resize(modelData.size() + modelDataStride);
+				std::memcpy(modelData.data() + modelData.size() - modelDataStride, &model, sizeof(MODEL_DATA));
+				draws.push_back(DRAW{ meshIndex, static_cast<unsigned>(firstRange), static_cast<unsigned>(drawRanges.size() - firstRange) });
+			}
+		}
+		if (draws.empty())
+			return;
+
+		//Every draw's MODEL_DATA in one call (a new buffer store each time, so the draws of the last call aren't waited on)
+		glBindBuffer(GL_UNIFORM_BUFFER, modelUBO);
+		glBufferData(GL_UNIFORM_BUFFER, modelData.size(), modelData.data(), GL_STREAM_DRAW);
+		//Binding the ModelData block to the MODEL_DATA UBO's static location of 2
+		glUniformBlockBinding(shaderExecutable, glGetUniformBlockIndex(shaderExecutable, "ModelData"), 2);
+		unsigned boundMesh = ~0u;
+		for (size_t d = 0; d < draws.size(); ++d) {
+			const MeshResource& mesh = *instances.meshes[draws[d].mesh];
+			if (draws[d].mesh != boundMesh) {
+				//Bind the vertex array & index buffer of the mesh, instances of one mesh in a row keep them
+				glBindVertexArray(mesh.GetVertexArray());
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.GetIndexBuffer());
+				boundMesh = draws[d].mesh;
+			}
+			//Point location 2 at this draw's MODEL_DATA
+			glBindBufferRange(GL_UNIFORM_BUFFER, 2, modelUBO, d * modelDataStride, sizeof(MODEL_DATA));
+			for (unsigned r = draws[d].firstRange; r < draws[d].firstRange + draws[d].rangeCount; ++r) {
+				glDrawElements(GL_TRIANGLES, drawRanges[r].indexCount, mesh.GetIndexType(),
+					(void*)(uintptr_t)(drawRanges[r].indexOffset * mesh.GetIndexSize()));
+				renderStats.drawnTriangles += drawRanges[r].indexCount / 3;
+				++renderStats.drawCalls;
+			}
+		}
+		//Return the GPU vertex array bind to 0, so Intel can display properly
+		glBindVertexArray(0);
 	}
 
-	//Draws a specified Model
-	//GLuint shaderExectuable - The location of the shaderExecutable that will draw the model
-	bool DrawModel(GLuint shaderExecutable) {
-		//EVERYTHING DONE ONCE PER LOOP
-		
-		//Bind the vertex array object before the draw so the data's can be drawn
-		glBindVertexArray(vertexArray); 
-		//Bind the index buffer before the draw so the data's location can be drawn
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferObject); 
+public:
 
-		//Get the location index of the uniform buffer in the GPU side
-		locShaderMats = glGetUniformBlockIndex(shaderExecutable, "ModelData"); 
+	//Chooses whether .h2b files are memory mapped & read in place (zero-copy) or copied through H2B::Parser
+	//bool enable - true to map files, takes effect for meshes loaded afterwards
+	inline void SetMappedLoading(bool enable) {
+		meshCache.SetMappedFiles(enable);
+	}
 
-		//Bind the buffer on the GPU side (in VRAM) to the MODEL_DATA UBO (which is set to a static location of 2)
-		glBindBufferBase(GL_UNIFORM_BUFFER, 2, UBO); 
+	//Chooses whether meshes are uploaded with 16 byte quantized vertices or 36 byte float vertices
+	//bool enable - true for compact vertices, takes effect for meshes loaded afterwards
+	inline void SetCompactVertices(bool enable) {
+		meshCache.SetCompactVertices(enable);
+	}
 
-		//Binding the block TO the buffer in VRAM for the MODEL_DATA UBO (which is set to a static location of 2)
-		glUniformBlockBinding(shaderExecutable, locShaderMats, 2); 
-		//Bind the UBO before the draw so the data's location can be drawn
-		glBindBuffer(GL_UNIFORM_BUFFER, UBO); 
+	//Chooses whether meshes are welded, get their triangles reordered for the post-transform vertex cache & less overdraw,
+	//grouped into meshlets that face one way, get their vertices reordered for fetch locality and simplified levels built while loading
+	//bool enable - true to run the passes, takes effect for meshes loaded afterwards
+	inline void SetLoadTimeOptimization(bool enable) {
+		optimizeOnLoad = enable;
+		H2B::OPTIMIZE_OPTIONS options;
+		options.weld = enable;
+		options.vertexCache = enable;
+		options.overdraw = enable;
+		options.meshlets = enable;
+		options.vertexFetch = enable;
+		options.lods = enable;
+		meshCache.SetOptimizeOptions(options);
+	}
 
-		for (int i = 0; i < cpuModel.meshCount; i++)
-		{
-			//Set the model's world matrix to the world matrix from the parse
-			model.worldMatrix = world; 
+	//Chooses how RenderLevel culls meshlets
+	//int mode - 0 draws everything, 1 skips meshlets outside the view frustum, 2 also skips meshlets facing away
+	inline void SetClusterCulling(int mode) {
+		clusterCulling = mode;
+	}
 
-			//Copy the parsed model material onto the model
-			model.material = cpuModel.materials[i].attrib; 
+	//Chooses when RenderLevel draws the simplified levels stored in the meshes (SECTION_LODS, see Tools/h2bCook)
+	//float pixelError - Largest on screen error a simplified level may show, 0 always draws full detail
+	inline void SetLodPixelError(float pixelError) {
+		lodPixelError = pixelError;
+	}
 
-			//Call SubBuffer and rewrite the entire UBO
-			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MODEL_DATA), &model);
+	//Chooses the color, range & spot cone of the level's lights (the exporter writes none) and the sun used when a level has none
+	//const LIGHT_DEFAULTS& defaults - Takes effect for levels loaded afterwards
+	inline void SetLightDefaults(const LIGHT_DEFAULTS& defaults) {
+		lightDefaults = defaults;
+	}
 
-			//Draw
-			glDrawElements(GL_TRIANGLES, cpuModel.meshes[i].drawInfo.indexCount, GL_UNSIGNED_INT, (void*)(cpuModel.meshes[i].drawInfo.indexOffset * sizeof(float)));
-		}
-		//Return the GPU vertex array bind to 0, so Intel can display properly
-		glBindVertexArray(0);
-		return true;
+	//Chooses how finely RenderLevel cuts the view into froxels for the light grid
+	//unsigned x, y - Screen tiles across & down
+	//unsigned z - Depth slices from the near to the far plane, 1 x 1 x 1 shades every light on every fragment
+	inline void SetLightGridSize(unsigned x, unsigned y, unsigned z) {
+		lightGridSize[0] = x;
+		lightGridSize[1] = y;
+		lightGridSize[2] = z;
 	}
 
-	//Frees all resources created on the GPU side (internal destructor)
-	//Destructs the vertex array object, vertex buffer object, index buffer object, and UBO created from the constructor
-	bool FreeResources() {
-		//DESTRUCTOR INFORMATION
-		glDeleteVertexArrays(1, &vertexArray);
-		glDeleteBuffers(1, &vertexBufferObject);
-		glDeleteBuffers(1, &indexBufferObject);
-		glDeleteBuffers(1, &UBO);
-	}
-
-	//Helper Methods For UploadModelData2GPU
-
-	//Creates a Vertex Buffer
-	//const void* data - The data to create a buffer for
-	//unsigned int sizeInBytes - The size of the parameter data in bytes
-	//GLuint& locVertexArray - The location of the vertex array
-	//GLuint& locVertexBufferObject - The location of the vertex buffer object
-	void CreateVertexBuffer(const void* data, unsigned int sizeInBytes, GLuint& locVertexArray, GLuint& locVertexBufferObject)
-	{
-		glGenVertexArrays(1, &locVertexArray);
-		glGenBuffers(1, &locVertexBufferObject);
-		glBindVertexArray(locVertexArray);
-		glBindBuffer(GL_ARRAY_BUFFER, locVertexBufferObject);
-		glBufferData(GL_ARRAY_BUFFER, sizeInBytes, data, GL_STATIC_DRAW);
-	}
-
-	//Creates a Index Buffer
-	//const void* data - The data to create a buffer for
-	//unsigned int sizeInBytes - The size of the parameter data in bytes
-	//GLuint& locIndexBufferObject - The location of the index buffer object
-	void CreateIndexBuffer(const void* data, unsigned int sizeInBytes, GLuint& locIndexBufferObject)
-	{
-		glGenBuffers(1, &locIndexBufferObject);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, locIndexBufferObject);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeInBytes, data, GL_STATIC_DRAW);
-	}
-
-	//Creates a Uniform Buffer Object
-	//const void* data - The data to create a buffer for
-	//unsigned int sizeInBytes - The size of the parameter data in bytes
-	//GLuint& locUBO - The location of the uniform buffer object (UBO)
-	void CreateUBO(const void* data, unsigned int sizeInBytes, GLuint& locUBO)
-	{
-		glGenBuffers(1, &locUBO);
-		glBindBuffer(GL_UNIFORM_BUFFER, locUBO);
-		glBufferData(GL_UNIFORM_BUFFER, sizeInBytes, data, GL_DYNAMIC_DRAW);
-	}
-
-	//Sets Vertex Attributes
-	//3 Vertex Attributes are bound by this function, for the Vertex's pos, uvw, and nrm variables
-	//VECTOR pos - The vertex's position
-	//VECTOR uvw - The vertex's uvw information
-	//VECTOR nrm - The vertex's normals
-	void SetVertexAttributes()
-	{
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, pos));
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, uvw));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, nrm));
-		glEnableVertexAttribArray(2);
+	//Chooses whether LoadLevel reads the compiled scene next to a GameLevel.txt (GameLevel.h2l, see Tools/levelCook)
+	//bool enable - true uses the compiled scene whenever it is at least as new as the text file
+	inline void SetCompiledScenes(bool enable) {
+		useCompiledScenes = enable;
 	}
-};
 
+	//Chooses how many threads LoadLevel parses the level's .h2b files on, the models still come out in file order
+	//unsigned threads - 0 for one per hardware thread, 1 to parse on the calling thread only, n for n threads
+	inline void SetLoadThreads(unsigned threads) {
+		if (threads != loadThreads)
+			loadPool = nullptr;
+		loadThreads = threads;
+	}
 
-class Level_Objects {
+	//Chooses where LoadLevel & UploadLevelToGPU record how long each of their phases takes (see load_trace.h)
+	//LoadTrace* trace - Must outlive the level's loading & upload, nullptr records nothing
+	inline void SetLoadTrace(LoadTrace* trace) {
+		meshCache.SetLoadTrace(trace);
+	}
+
+	//Returns the LIGHT blocks of the loaded level's GameLevel.txt, in file order
+	inline const std::vector<LEVEL_OBJECT>& GetLights() const {
+		return levelFile.lights;
+	}
 
-	// store all our models
-	std::list<Model> allObjectsInLevel;
+	//Returns the CAMERA blocks of the loaded level's GameLevel.txt, in file order
+	inline const std::vector<LEVEL_OBJECT>& GetCameras() const {
+		return levelFile.cameras;
+	}
 
-public:
+	//Returns the index of the first model of a name in the GameLevel ("MovingPlatform.002"), false if there is none
+	//size_t& model - Receives the index, for the model transform functions below
+	bool FindModel(const char* name, size_t& model) const {
+		for (size_t i = 0; i < instances.Size(); ++i)
+			if (instances.names[i] == name) {
+				model = i;
+				return true;
+			}
+		return false;
+	}
+
+	//Makes a model follow another one (crates riding a MovingPlatform), it stays where it is until either moves
+	//Returns false if the parent is the model itself or follows it
+	//size_t model - Index from FindModel
+	//size_t parent - Model to follow, SIZE_MAX makes the model stand on its own again
+	bool SetModelParent(size_t model, size_t parent) {
+		UpdateTransforms();
+		return transforms.SetParent(static_cast<unsigned>(model), parent == SIZE_MAX ? -1 : static_cast<int>(parent));
+	}
+
+	//Moves a model relative to its parent (the world for a model without one), the models following it move along
+	//The world matrices are recomputed by the next RenderLevel (or UpdateTransforms), for this model's subtree only
+	//size_t model - Index from FindModel
+	//const GW::MATH::GMATRIXF& local - Row major matrix relative to the parent
+	inline void SetModelMatrix(size_t model, const GW::MATH::GMATRIXF& local) {
+		transforms.SetLocalMatrix(static_cast<unsigned>(model), local.data);
+	}
+
+	//Returns a model's matrix relative to its parent
+	inline const GW::MATH::GMATRIXF& GetModelMatrix(size_t model) const {
+		return transforms.GetLocalMatrix(static_cast<unsigned>(model));
+	}
+
+	//Returns a model's world matrix as of the last RenderLevel (or UpdateTransforms)
+	inline const GW::MATH::GMATRIXF& GetModelWorldMatrix(size_t model) const {
+		return instances.worlds[model];
+	}
+
+	//Recomputes the world matrices (& bounds) of the models that moved and of everything following them
+	//Returns the number of models recomputed, 0 without a call to SetModelMatrix or SetModelParent since the last one
+	size_t UpdateTransforms() {
+		size_t updated = transforms.Update();
+		for (unsigned model : transforms.GetChanged())
+			instances.SetWorldMatrix(model, transforms.GetWorldMatrix(model));
+		return updated;
+	}
+
+	//Returns what the last RenderLevel submitted
+	inline const RENDER_STATS& GetRenderStats() const {
+		return renderStats;
+	}
 	
-	// Imports the default level txt format and creates a Model from each .h2b
+	// Imports the default level txt format and creates an instance (see level_instances.h) from each MESH block
 	bool LoadLevel(	const char* gameLevelPath,
 					const char* h2bFolderPath,
-					GW::SYSTEM::GLog log) {
+					AsyncLog log) {
 		
 		// What this does:
-		// Parse GameLevel.txt 
+		// Map GameLevel.h2l if it is newer than GameLevel.txt (see SetCompiledScenes), else parse GameLevel.txt 
 		// For each model found in the file...
-			// Create a new Model class on the stack.
-				// Read matrix transform and add to this model.
-				// Load all CPU rendering data for this model from .h2b
-			// Move the newly found Model to our list of total models for the level 
+			// Read its name, matrix transform and the .h2b it draws (matched against one listing of the model folder).
+		// Parse every .h2b not in the mesh cache yet, several at once on the load thread pool (see SetLoadThreads)
+		// For each model found, in file order...
+			// Get the shared CPU rendering data for this model's .h2b from the mesh cache
+			// Add its name, matrix transform and mesh to the level's instance arrays
 
-		log.LogCategorized("EVENT", "LOADING GAME LEVEL [OBJECT ORIENTED]");
-		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
+		log.Write<LOG_EVENT>("LOADING GAME LEVEL [OBJECT ORIENTED]");
+		log.Write<LOG_MESSAGE>("Begin Reading Game Level Text File.");
+		LoadTrace* trace = meshCache.GetLoadTrace();
+		LoadTimer loadTimer(trace, "Load Level", 0, gameLevelPath);
 
 		UnloadLevel();// clear previous level data if there is any
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
-			log.LogCategorized(
-				"ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
+		// models in the order they appear in the file, with the .h2b each one needs
+		struct LEVEL_ENTRY {
+			const char* name;
+			const float* world;
+			std::string modelFile;
+		};
+		std::vector<LEVEL_ENTRY> entries;
+		// a compiled scene (Tools/levelCook) newer than the text is used in place, names & matrices straight from the mapping
+		H2B::MappedScene scene;
+		std::string scenePath = H2B::GetScenePath(gameLevelPath);
+		bool compiled = useCompiledScenes && IsSceneCurrent(gameLevelPath, scenePath) && scene.Open(scenePath.c_str());
+		bool parsed = false;
+		if (!compiled) {
+			LoadTimer timer(trace, "Parse GameLevel", TracedFileSize(trace, gameLevelPath), gameLevelPath);
+			parsed = levelFile.Parse(gameLevelPath);
+		}
+		if (compiled) {
+			LoadTimer timer(trace, "Read Compiled Scene", TracedFileSize(trace, scenePath), scenePath);
+			log.Write<LOG_INFO>("Reading Compiled Scene: %s", scenePath.c_str());
+			for (unsigned i = 0; i < scene.lightCount; ++i)
+				levelFile.AddObject(LEVEL_LIGHT, scene.GetString(scene.lights[i].name), scene.lights[i].world);
+			for (unsigned i = 0; i < scene.cameraCount; ++i)
+				levelFile.AddObject(LEVEL_CAMERA, scene.GetString(scene.cameras[i].name), scene.cameras[i].world);
+			entries.reserve(scene.entityCount);
+			for (unsigned i = 0; i < scene.entityCount; ++i) {
+				const char* meshFile = scene.GetMeshFile(scene.entities[i]);
+				entries.push_back({ scene.GetString(scene.entities[i].name), scene.entities[i].world,
+					std::string(h2bFolderPath) + "/" + (meshFile ? meshFile : "") });
+			}
+		}
+		// one pass over the mapped file, LIGHT & CAMERA blocks are kept for the renderer (see GetLights/GetCameras)
+		else if (parsed) {
+			for (size_t line : levelFile.malformedLines)
+				log.Write<LOG_WARNING>("Skipped malformed block on line %zu of %s", line, gameLevelPath);
+			// the model folder is listed once, each name is then matched to its .h2b without touching the disk
+			LoadTimer timer(trace, "Resolve Model Files", 0, h2bFolderPath);
+			if (!modelFiles.Scan(h2bFolderPath))
+				log.Write<LOG_ERROR>("Model folder not found: %s", h2bFolderPath);
+			entries.reserve(levelFile.meshes.size());
+			for (auto& object : levelFile.meshes)
+				entries.push_back({ object.name, object.world, modelFiles.ResolvePath(object.name) });
+		}
+		else {
+			log.Write<LOG_ERROR>("Game level not found: %s", gameLevelPath);
 			return false;
 		}
-		char linebuffer[1024];
-		while (+file.ReadLine(linebuffer, 1024, '\n'))
+		for (auto& light : levelFile.lights)
+			log.Write<LOG_INFO>("Light Detected: %s", light.name);
+		for (auto& camera : levelFile.cameras)
+			log.Write<LOG_INFO>("Camera Detected: %s", camera.name);
+		for (auto& entry : entries) {
+			log.Write<LOG_INFO>("Model Detected: %s", entry.name);
+			log.Write<LOG_INFO>("Location: X %f Y %f Z %f", entry.world[12], entry.world[13], entry.world[14]);
+		}
+
+		// parse the unique .h2b files side by side, remembering which ones an earlier level already loaded
+		std::vector<std::string> uniqueFiles;
+		std::unordered_map<std::string, bool> cachedBefore;
+		for (auto& entry : entries)
+			if (cachedBefore.emplace(entry.modelFile, meshCache.Contains(entry.modelFile)).second)
+				uniqueFiles.push_back(entry.modelFile);
+		log.Write<LOG_MESSAGE>("Begin Importing %zu .H2B Files on %u Thread(s).", uniqueFiles.size(), unsigned(GetLoadThreadCount()));
 		{
-			// having to have this is a bug, need to have Read/ReadLine return failure at EOF
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0) //Check to find a line with just the word MESH
-			{
-				Model newModel;
-				file.ReadLine(linebuffer, 1024, '\n');
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + linebuffer).c_str());
-				// create the model file name from this (strip the .001)
-				newModel.SetName(linebuffer);
-				std::string modelFile = linebuffer;
-				modelFile = modelFile.substr(0, modelFile.find_last_of("."));
-				modelFile += ".h2b";
-
-				// now read the transform data as we will need that regardless
-				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					// read floats
-					std::sscanf(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
-				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				// Add new model to list of all Models
-				log.LogCategorized("MESSAGE", "Begin Importing .H2B File Data.");
-				modelFile = std::string(h2bFolderPath) + "/" + modelFile;
-				newModel.SetWorldMatrix(transform);
-				// If we find and load it add it to the level
-				if (newModel.LoadModelDataFromDisk(modelFile.c_str())) {
-					// add to our level objects, we use std::move since Model::cpuModel is not copy safe.
-					allObjectsInLevel.push_back(std::move(newModel));
-					log.LogCategorized("INFO", (std::string("H2B Imported: ") + modelFile).c_str());
-				}
-				else {
-					// notify user that a model file is missing but continue loading
-					log.LogCategorized("ERROR",
-						(std::string("H2B Not Found: ") + modelFile).c_str());
-					log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
+			LoadTimer timer(trace, "Load .h2b Files");
+			meshCache.Preload(uniqueFiles, GetLoadPool());
+		}
+
+		// build the models in file order so the level comes out the same however the parsing was scheduled
+		for (auto& entry : entries) {
+			log.Write<LOG_MESSAGE>("Begin Importing .H2B File Data.");
+			const std::string& modelFile = entry.modelFile;
+			// If we found and loaded it (or already did for another instance) add it to the level
+			bool& wasCached = cachedBefore[modelFile];
+			std::shared_ptr<MeshResource> mesh = meshCache.Acquire(modelFile);
+			if (mesh) {
+				if (!wasCached && optimizeOnLoad) {
+					const H2B::OPTIMIZE_REPORT& report = mesh->GetOptimizeReport();
+					log.Write<LOG_INFO>("Vertices %zu -> %zu, Vertex Cache ACMR %f -> %f, ATVR %f -> %f", size_t(report.verticesBefore), size_t(report.verticesAfter),
+						double(report.before.acmr), double(report.after.acmr), double(report.before.atvr), double(report.after.atvr));
+					for (size_t l = 0; l < report.lods.size(); ++l)
+						log.Write<LOG_INFO>("LOD %zu: %zu triangles, error %f", l + 1, size_t(report.lods[l].triangleCount), double(report.lods[l].error));
 				}
-				log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
+				// Add new model to the level's instances
+				instances.Add(entry.name, entry.world, std::move(mesh));
+				transforms.Add(entry.world);
+				log.Write<LOG_INFO>(wasCached ? "H2B Reused: %s" : "H2B Imported: %s", modelFile.c_str());
 			}
-			if (std::strcmp(linebuffer, "LIGHT") == 0) //Check to find a line with just the word LIGHT
-			{
-				
+			else {
+				// notify user that a model file is missing but continue loading
+				log.Write<LOG_ERROR>("H2B Not Found: %s", modelFile.c_str());
+				log.Write<LOG_WARNING>("Loading will continue but model(s) are missing.");
 			}
+			// later models using this file reuse it
+			wasCached = true;
+			log.Write<LOG_MESSAGE>("Importing of .H2B File Data Complete.");
 		}
-		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
+		// the instances already hold the file's matrices, nothing needs recomputing until a model moves
+		transforms.Update();
+		directionalLights = BuildLights(levelFile.lights, lightDefaults, lights);
+		log.Write<LOG_INFO>("%zu Lights (%u Directional).", lights.size(), directionalLights);
+		log.Write<LOG_MESSAGE>("Game Level File Reading Complete.");
+		log.Write<LOG_INFO>("%zu Models share %zu unique .H2B Meshes.", instances.Size(), size_t(meshCache.Size()));
 		// level loaded into CPU ram
-		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [OBJECT ORIENTED]");
+		log.Write<LOG_EVENT>("GAME LEVEL WAS LOADED TO CPU [OBJECT ORIENTED]");
 		return true;
 	}
 
 	// Upload the CPU level to GPU
 	void UploadLevelToGPU() {
-		// iterate over each model and tell it to draw itself
-		for (auto& e : allObjectsInLevel) {
-			e.UploadModelData2GPU(/*forward handle to API device if needed*/);
+		LoadTimer timer(meshCache.GetLoadTrace(), "Upload Level");
+		// each unique mesh is uploaded once, no matter how many models use it
+		meshCache.UploadAllToGPU(/*forward handle to API device if needed*/);
+		// one UBO holds the MODEL_DATA of every draw, each at an offset a uniform block may be bound at
+		if (modelUBO == 0) {
+			GLint alignment = 256;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			modelDataStride = (sizeof(MODEL_DATA) + alignment - 1) / alignment * alignment;
+			glGenBuffers(1, &modelUBO);
+			glBindBuffer(GL_UNIFORM_BUFFER, modelUBO);
+			glBufferData(GL_UNIFORM_BUFFER, modelDataStride, nullptr, GL_STREAM_DRAW);
 		}
+		// the lights only change with the level, the grid buffers are filled by RenderLevel
+		if (lightBuffer == 0) {
+			GPU_LIGHT none = {};
+			glGenBuffers(1, &lightBuffer);
+			glGenBuffers(1, &clusterBuffer);
+			glGenBuffers(1, &lightIndexBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPU_LIGHT) * std::max<size_t>(1, lights.size()),
+				lights.empty() ? &none : lights.data(), GL_STATIC_DRAW);
+		}
+	}
+
+	// Uploads the CPU level to GPU a slice at a time, so a level loaded in the background doesn't stall a frame
+	// Returns true once everything is uploaded, call it again (next frame) while it returns false
+	// size_t byteBudget - About how many bytes of meshes to upload in this call (at least one mesh is)
+	bool UploadLevelToGPU(size_t byteBudget) {
+		if (!meshCache.UploadSomeToGPU(byteBudget))
+			return false;
+		UploadLevelToGPU();
+		return true;
 	}
 
-	// Draws all objects in the level
+	// Exchanges the loaded level (models, meshes & GPU buffers) with another Level_Objects, the settings of both stay
+	// Used to switch to a level loaded & uploaded in the background between two frames
+	void SwapLevel(Level_Objects& other) {
+		instances.Swap(other.instances);
+		transforms.Swap(other.transforms);
+		std::swap(levelFile, other.levelFile);
+		meshCache.SwapMeshes(other.meshCache);
+		std::swap(modelUBO, other.modelUBO);
+		std::swap(modelDataStride, other.modelDataStride);
+		lights.swap(other.lights);
+		std::swap(directionalLights, other.directionalLights);
+		std::swap(lightBuffer, other.lightBuffer);
+		std::swap(clusterBuffer, other.clusterBuffer);
+		std::swap(lightIndexBuffer, other.lightIndexBuffer);
+		renderStats = RENDER_STATS();
+		other.renderStats = RENDER_STATS();
+	}
+
+	// Adds up the RAM & VRAM the level's meshes hold (see MeshCache::GetMemoryUsage)
+	void GetMemoryUsage(size_t& cpuBytes, size_t& gpuBytes) const {
+		meshCache.GetMemoryUsage(cpuBytes, gpuBytes);
+	}
+
+	// Makes LoadLevel & UploadLevelToGPU of this level work like another's (mapped/compact/optimized meshes, load threads)
+	void CopyLoadSettings(const Level_Objects& other) {
+		meshCache.CopySettings(other.meshCache);
+		optimizeOnLoad = other.optimizeOnLoad;
+		useCompiledScenes = other.useCompiledScenes;
+		lightDefaults = other.lightDefaults;
+		std::memcpy(lightGridSize, other.lightGridSize, sizeof(lightGridSize));
+		SetLoadThreads(other.loadThreads);
+	}
+
+	// Draws all objects in the level, every light shading every fragment
 	void RenderLevel(GLuint shaderExecutable) {
-		// iterate over each model and tell it to draw itself
-		for (auto &e : allObjectsInLevel) {
-			e.DrawModel(shaderExecutable);
+		UploadLightGrid(nullptr, nullptr);
+		Render(shaderExecutable, nullptr, nullptr, nullptr);
+		AddLightStats();
+	}
+
+	// Draws all objects in the level, skipping models & meshlets the camera can't see (see SetClusterCulling)
+	// and drawing far models simplified (see SetLodPixelError, viewportHeight is in pixels)
+	void RenderLevel(GLuint shaderExecutable, const GW::MATH::GMATRIXF& viewMatrix, const GW::MATH::GMATRIXF& projectionMatrix,
+		const GW::MATH::GVECTORF& cameraPos, float viewportHeight = 0) {
+		CULL_VIEW settings = {};
+		settings.cullFrustum = clusterCulling >= 1;
+		settings.cullBackfaces = clusterCulling >= 2;
+		settings.lodErrorPerDistance = GetLodErrorPerDistance(projectionMatrix.data, viewportHeight, lodPixelError);
+		// point & spot lights are listed per froxel of this view
+		UploadLightGrid(viewMatrix.data, projectionMatrix.data);
+		if (!settings.cullFrustum && settings.lodErrorPerDistance <= 0)
+			Render(shaderExecutable, nullptr, nullptr, nullptr);
+		else {
+			float viewProjection[16];
+			MultiplyMatrix4(viewMatrix.data, projectionMatrix.data, viewProjection);
+			const float camera[3] = { cameraPos.x, cameraPos.y, cameraPos.z };
+			Render(shaderExecutable, &settings, viewProjection, camera);
 		}
+		AddLightStats();
 	}
 
 	// used to wipe CPU & GPU level data between levels
 	void UnloadLevel() {
-		allObjectsInLevel.clear();
+		instances.Clear();
+		transforms.Clear();
+		levelFile.Clear();
+		// the instances held the last references, so this frees every mesh's CPU & GPU data
+		meshCache.Clear();
+		if (modelUBO != 0) {
+			glDeleteBuffers(1, &modelUBO);
+			modelUBO = 0;
+		}
+		lights.clear();
+		directionalLights = 0;
+		if (lightBuffer != 0) {
+			GLuint buffers[3] = { lightBuffer, clusterBuffer, lightIndexBuffer };
+			glDeleteBuffers(3, buffers);
+			lightBuffer = clusterBuffer = lightIndexBuffer = 0;
+		}
 	}
 
 	// *THIS APPROACH COMBINES DATA & LOGIC* 
 	// *WITH THIS APPROACH THE CURRENT RENDERER SHOULD BE JUST AN API MANAGER CLASS*
-	// *ALL ACTUAL GPU LOADING AND RENDERING SHOULD BE HANDLED BY THE MODEL CLASS* 
+	// *ALL ACTUAL GPU LOADING AND RENDERING SHOULD BE HANDLED BY THE LEVEL CLASS* 
 	// For example: anything that is not a global API object should be encapsulated.
+	// The per model data is kept in parallel arrays (LevelInstances) rather than one object per model,
+	// so the passes over every model each frame stay linear.
 };
 
@@ -0,0 +1,137 @@
+// Timeline of where level loading spends its time, written as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+// A LoadTimer measures one phase from its construction to the end of its scope and adds it to a LoadTrace with the
+// thread it ran on and the bytes it went through. Code that was handed no LoadTrace (nullptr) times nothing.
+// Phases recorded: GameLevel parse, model file resolution, .h2b read & decode, vertex processing (optimize, meshlets,
+// LODs, compact encoding), GPU buffer creation and shader compiles, inside one span per LoadLevel & upload.
+#ifndef _LOAD_TRACE_H_
+#define _LOAD_TRACE_H_
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LoadTrace {
+public:
+	// One finished phase
+	struct EVENT {
+		const char* name; // phase, a string literal
+		std::string detail; // file the phase worked on, if any
+		long long start; // microseconds since the LoadTrace was created
+		long long duration; // microseconds
+		unsigned thread;
+		size_t bytes; // read, decoded or uploaded, 0 if not counted
+	};
+
+private:
+	std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+	// phases finish on the loading threads, the GL thread & the pool workers at once
+	mutable std::mutex lock;
+	std::vector<EVENT> events;
+
+	// Writes a string as a JSON string literal
+	static void WriteString(std::FILE* file, const char* text) {
+		std::fputc('"', file);
+		for (; *text; ++text) {
+			unsigned char c = static_cast<unsigned char>(*text);
+			if (c == '"' || c == '\\')
+				std::fprintf(file, "\\%c", c);
+			else if (c < 0x20)
+				std::fprintf(file, "\\u%04x", c);
+			else
+				std::fputc(c, file);
+		}
+		std::fputc('"', file);
+	}
+
+public:
+	//Returns the calling thread's id as the trace shows it
+	static unsigned ThreadId() {
+		thread_local unsigned id = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000);
+		return id;
+	}
+
+	//Returns the microseconds since the LoadTrace was created
+	long long Now() const {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	//Records a finished phase, safe from any thread
+	void Add(EVENT event) {
+		std::lock_guard<std::mutex> guard(lock);
+		events.push_back(std::move(event));
+	}
+
+	//Returns the number of phases recorded so far
+	size_t Size() const {
+		std::lock_guard<std::mutex> guard(lock);
+		return events.size();
+	}
+
+	//Forgets every recorded phase
+	void Clear() {
+		std::lock_guard<std::mutex> guard(lock);
+		events.clear();
+	}
+
+	//Writes every phase recorded so far as Chrome trace JSON, replacing the file
+	//Returns false if it can't be written
+	//const char* fileName - Path of the .json file
+	bool Write(const char* fileName) const {
+		std::FILE* file = std::fopen(fileName, "w");
+		if (file == nullptr)
+			return false;
+		std::lock_guard<std::mutex> guard(lock);
+		std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		for (size_t i = 0; i < events.size(); ++i) {
+			const EVENT& e = events[i];
+			std::fprintf(file, "{\"name\":");
+			WriteString(file, e.name);
+			std::fprintf(file, ",\"cat\":\"load\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,\"args\":{\"bytes\":%zu",
+				e.thread, e.start, e.duration, e.bytes);
+			if (!e.detail.empty()) {
+				std::fprintf(file, ",\"file\":");
+				WriteString(file, e.detail.c_str());
+			}
+			std::fprintf(file, "}}%s\n", i + 1 < events.size() ? "," : "");
+		}
+		std::fprintf(file, "]}\n");
+		return std::fclose(file) == 0;
+	}
+};
+
+// Times the rest of its scope as one phase of a LoadTrace
+class LoadTimer {
+	LoadTrace* trace;
+	LoadTrace::EVENT event;
+
+public:
+	//LoadTrace* trace - Receives the phase when the timer goes out of scope, nullptr times nothing
+	//const char* name - Phase, a string literal ("Decode .h2b")
+	//size_t bytes - Bytes the phase goes through, SetBytes sets them once known
+	//const std::string& detail - File the phase works on
+	LoadTimer(LoadTrace* trace, const char* name, size_t bytes = 0, const std::string& detail = std::string()) : trace(trace) {
+		if (trace == nullptr)
+			return;
+		event.name = name;
+		event.detail = detail;
+		event.bytes = bytes;
+		event.thread = LoadTrace::ThreadId();
+		event.start = trace->Now();
+	}
+	LoadTimer(const LoadTimer&) = delete;
+	LoadTimer& operator=(const LoadTimer&) = delete;
+	~LoadTimer() {
+		if (trace == nullptr)
+			return;
+		event.duration = trace->Now() - event.start;
+		trace->Add(std::move(event));
+	}
+
+	inline void SetBytes(size_t bytes) {
+		event.bytes = bytes;
+	}
+};
+#endif
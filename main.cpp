@@ -25,7 +25,7 @@ using namespace GRAPHICS;
 // lets pop a window and use OpenGL to render to a window
 int main()
 {
-	GLog log; // handy for logging any messages/warning/errors
+	AsyncLog log; // handy for logging any messages/warning/errors (written on a background thread)
 	log.Create("../LevelLoaderLog.txt");
 	log.EnableConsoleLogging(true); // mirror output to the console
 	log.Log("Start Program.");
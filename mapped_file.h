@@ -0,0 +1,129 @@
+// Read-only memory mapped file.
+// The mapped bytes come straight from the OS page cache, nothing is copied into the process.
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+#include <cstddef>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile {
+	const void* data = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept {
+		*this = static_cast<MappedFile&&>(other);
+	}
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			Close();
+			data = other.data; other.data = nullptr;
+			size = other.size; other.size = 0;
+#if defined(_WIN32)
+			file = other.file; other.file = INVALID_HANDLE_VALUE;
+			mapping = other.mapping; other.mapping = nullptr;
+#endif
+		}
+		return *this;
+	}
+	~MappedFile() {
+		Close();
+	}
+
+	//Maps an entire file read-only, returns false if it can't be opened or is empty
+	//const char* path - The file to map
+	bool Open(const char* path) {
+		Close();
+#if defined(_WIN32)
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			Close();
+			return false;
+		}
+		data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+			::close(fd);
+			return false;
+		}
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping keeps its own reference to the file
+		if (view == MAP_FAILED)
+			return false;
+		madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+		data = view;
+		size = static_cast<size_t>(info.st_size);
+#endif
+		if (data == nullptr) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	//Unmaps the file, every pointer into it becomes invalid
+	void Close() {
+#if defined(_WIN32)
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data)
+			munmap(const_cast<void*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+	}
+
+	//Returns the first byte of the mapping (nullptr if nothing is mapped)
+	inline const char* Data() const {
+		return static_cast<const char*>(data);
+	}
+
+	//Returns the number of mapped bytes
+	inline size_t Size() const {
+		return size;
+	}
+
+	//Returns true if a file is currently mapped
+	inline bool IsOpen() const {
+		return data != nullptr;
+	}
+};
+#endif
@@ -0,0 +1,577 @@
+// Shared mesh resources for a level.
+// Every .h2b file is parsed and uploaded once, no matter how many Models in the GameLevel reference it.
+#ifndef _MESH_CACHE_H_
+#define _MESH_CACHE_H_
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// This reads .h2b files which are optimized binary .obj+.mtl files
+#include "h2bParser.h"
+// 16 byte quantized vertex layout
+#include "h2bCompactVertex.h"
+// 32 -> 16 bit index narrowing
+#include "h2bIndices.h"
+// Load time triangle reordering
+#include "h2bOptimize.h"
+// Per cluster bounds for culling
+#include "h2bMeshlets.h"
+// Simplified levels of detail
+#include "h2bSimplify.h"
+// Parses several files at once
+#include "thread_pool.h"
+// Timing of the load phases
+#include "load_trace.h"
+
+// CPU & GPU data of a single .h2b file, shared (reference counted) by every Model using it
+class MeshResource {
+	// Resolved .h2b path this mesh was loaded from (the cache key)
+	std::string path;
+	// Loads and stores CPU model data from .h2b file
+	H2B::Parser cpuModel;
+	// Zero-copy alternative to cpuModel, used instead of it when the mesh was loaded mapped
+	H2B::MappedParser mappedModel;
+	bool mapped = false;
+	// Upload vertices in the 16 byte H2B::COMPACT_VERTEX layout instead of 36 byte H2B::VERTEX
+	bool compact = false;
+	// Ranges the compact vertices were quantized with (shaders need them to decode)
+	H2B::QUANTIZATION quantization = { { 0, 0, 0, 0 }, { 1, 1, 1, 1 }, { 0, 0, 1, 1 } };
+	// Passes run over the mesh right after it is parsed, and what they did
+	H2B::OPTIMIZE_OPTIONS optimizeOptions;
+	H2B::OPTIMIZE_REPORT optimizeReport;
+	// Clusters of the index buffer with their bounds (from the file's SECTION_MESHLETS, or cut in stored order)
+	std::vector<H2B::MESHLET> meshlets;
+	// The meshlets of each H2B::MESH, count 0 draws the mesh whole
+	std::vector<H2B::MESHLET_RANGE> meshletRanges;
+	// Simplified levels from the file's SECTION_LODS (empty without one), uploaded after the file's indices
+	H2B::LOD_CHAIN lods;
+	// Receives the time spent reading, decoding, processing & uploading this mesh (nullptr times nothing)
+	LoadTrace* trace = nullptr;
+
+	// Vertex Buffer
+	GLuint vertexArray = 0;
+	GLuint vertexBufferObject = 0;
+	// Index Buffer
+	GLuint indexBufferObject = 0;
+	// GL_UNSIGNED_SHORT when the indices were narrowed to 16 bits, GL_UNSIGNED_INT otherwise
+	GLenum indexType = GL_UNSIGNED_INT;
+
+public:
+	MeshResource() = default;
+	MeshResource(const MeshResource&) = delete;
+	MeshResource& operator=(const MeshResource&) = delete;
+	~MeshResource() {
+		FreeResources();
+	}
+
+	//Returns the resolved .h2b path of this mesh
+	inline const std::string& GetPath() const {
+		return path;
+	}
+
+	//Returns true if the mesh data points straight into a memory mapped .h2b file
+	inline bool IsMapped() const {
+		return mapped;
+	}
+
+	//Accessors for the CPU data of this mesh, valid whichever way it was loaded
+	inline unsigned GetVertexCount() const {
+		return mapped ? mappedModel.vertexCount : cpuModel.vertexCount;
+	}
+	inline const H2B::VERTEX* GetVertices() const {
+		return mapped ? mappedModel.vertices : cpuModel.vertices.data();
+	}
+	inline unsigned GetIndexCount() const {
+		return mapped ? mappedModel.indexCount : cpuModel.indexCount;
+	}
+	inline const unsigned* GetIndices() const {
+		return mapped ? mappedModel.indices : cpuModel.indices.data();
+	}
+	inline const std::vector<H2B::MATERIAL>& GetMaterials() const {
+		return mapped ? mappedModel.materials : cpuModel.materials;
+	}
+	inline const std::vector<H2B::MESH>& GetMeshes() const {
+		return mapped ? mappedModel.meshes : cpuModel.meshes;
+	}
+
+	//Returns the meshlets of this mesh & the meshlets of each H2B::MESH (same order as GetMeshes)
+	inline const std::vector<H2B::MESHLET>& GetMeshlets() const {
+		return meshlets;
+	}
+	inline const std::vector<H2B::MESHLET_RANGE>& GetMeshletRanges() const {
+		return meshletRanges;
+	}
+
+	//Returns the number of simplified levels (0 when the file stores none)
+	inline unsigned GetLodCount() const {
+		return static_cast<unsigned>(lods.levels.size());
+	}
+
+	//Returns the largest geometric error of a simplified level in model units
+	//unsigned lod - 1 to GetLodCount()
+	inline float GetLodError(unsigned lod) const {
+		return lods.levels[lod - 1].error;
+	}
+
+	//Returns the uploaded index range of a mesh in a simplified level
+	//unsigned lod - 1 to GetLodCount()
+	//size_t mesh - Index into GetMeshes()
+	inline H2B::BATCH GetLodDraw(unsigned lod, size_t mesh) const {
+		H2B::BATCH draw = lods.GetDraw(lod, mesh, GetMeshes().size());
+		draw.indexOffset += GetIndexCount();
+		return draw;
+	}
+
+	//Returns the box & sphere around all vertices and around each H2B::MESH (model space, same order as GetMeshes)
+	inline const H2B::BOUNDS& GetBounds() const {
+		return mapped ? mappedModel.bounds : cpuModel.bounds;
+	}
+	inline const std::vector<H2B::BOUNDS>& GetMeshBounds() const {
+		return mapped ? mappedModel.meshBounds : cpuModel.meshBounds;
+	}
+
+	//Chooses the vertex layout used by the next UploadToGPU
+	//bool enable - true for 16 byte quantized vertices, false for 36 byte float vertices
+	inline void SetCompactVertices(bool enable) {
+		compact = enable;
+	}
+
+	//Returns true if the uploaded vertices are in the compact layout
+	inline bool UsesCompactVertices() const {
+		return compact;
+	}
+
+	//Returns the ranges needed to decode compact vertices (identity for float vertices)
+	inline const H2B::QUANTIZATION& GetQuantization() const {
+		return quantization;
+	}
+
+	//Chooses the optimization passes run by the next LoadFromDisk
+	//const H2B::OPTIMIZE_OPTIONS& options - Passes to run, nothing is run by default
+	inline void SetOptimizeOptions(const H2B::OPTIMIZE_OPTIONS& options) {
+		optimizeOptions = options;
+	}
+
+	//Returns the vertex cache stats measured before and after the load time passes
+	inline const H2B::OPTIMIZE_REPORT& GetOptimizeReport() const {
+		return optimizeReport;
+	}
+
+	//Chooses where LoadFromDisk & UploadToGPU record their phases
+	//LoadTrace* loadTrace - Must outlive the mesh's loading & upload, nullptr records nothing
+	inline void SetLoadTrace(LoadTrace* loadTrace) {
+		trace = loadTrace;
+	}
+
+	//Returns the vertex array object of this mesh (0 until uploaded)
+	inline GLuint GetVertexArray() const {
+		return vertexArray;
+	}
+
+	//Returns the index buffer object of this mesh (0 until uploaded)
+	inline GLuint GetIndexBuffer() const {
+		return indexBufferObject;
+	}
+
+	//Returns the type of the uploaded indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+	inline GLenum GetIndexType() const {
+		return indexType;
+	}
+
+	//Returns the size in bytes of one uploaded index
+	inline unsigned int GetIndexSize() const {
+		return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+	}
+
+	//Returns true once the mesh lives in VRAM
+	inline bool IsUploaded() const {
+		return vertexArray != 0;
+	}
+
+	//Returns about how many bytes of RAM the mesh holds (a mapped mesh's vertices & indices are counted, they stay in the page cache)
+	inline size_t GetCpuSize() const {
+		return sizeof(H2B::VERTEX) * GetVertexCount() + sizeof(unsigned int) * (size_t(GetIndexCount()) + lods.indices.size()) +
+			sizeof(H2B::MESHLET) * meshlets.size() + sizeof(H2B::MESHLET_RANGE) * meshletRanges.size();
+	}
+
+	//Returns how many bytes of VRAM the uploaded vertex & index buffers take, 0 until uploaded
+	inline size_t GetGpuSize() const {
+		if (!IsUploaded())
+			return 0;
+		size_t vertexSize = compact ? sizeof(H2B::COMPACT_VERTEX) : sizeof(H2B::VERTEX);
+		return vertexSize * GetVertexCount() + GetIndexSize() * (size_t(GetIndexCount()) + lods.indices.size());
+	}
+
+	//Returns about how many bytes UploadToGPU sends to the GPU (vertices in the chosen layout plus 32 bit indices)
+	inline size_t GetUploadSize() const {
+		size_t vertexSize = compact ? sizeof(H2B::COMPACT_VERTEX) : sizeof(H2B::VERTEX);
+		return vertexSize * GetVertexCount() + sizeof(unsigned int) * (size_t(GetIndexCount()) + lods.indices.size());
+	}
+
+	//Parses the .h2b file into CPU memory
+	//const std::string& h2bPath - The resolved path of the .h2b file
+	//bool useMappedFile - Map the file and read vertices/indices/names in place instead of copying them
+	//Optimization passes need writable data, so a mesh they run on is always copied (cook files offline to keep zero-copy)
+	bool LoadFromDisk(const std::string& h2bPath, bool useMappedFile = false) {
+		path = h2bPath;
+		mapped = useMappedFile && !optimizeOptions.Enabled();
+		if (mapped) {
+			// the file is read by the page faults of the decode
+			LoadTimer timer(trace, "Map & Decode .h2b", 0, h2bPath);
+			if (!mappedModel.Parse(h2bPath.c_str()))
+				return false;
+			timer.SetBytes(size_t(36) * mappedModel.vertexCount + size_t(4) * mappedModel.indexCount);
+		}
+		else {
+			// one read of the whole file, then decoded from memory (same result as cpuModel.Parse)
+			std::unique_ptr<char[]> fileBuffer;
+			size_t fileSize = 0;
+			{
+				LoadTimer timer(trace, "Read .h2b", 0, h2bPath);
+				if (!H2B::Parser::ReadFile(h2bPath.c_str(), fileBuffer, fileSize))
+					return false;
+				timer.SetBytes(fileSize);
+			}
+			{
+				LoadTimer timer(trace, "Decode .h2b", fileSize, h2bPath);
+				if (!cpuModel.ParseFromMemory(fileBuffer.get(), fileSize))
+					return false;
+			}
+			fileBuffer.reset();
+			if (optimizeOptions.Enabled()) {
+				LoadTimer timer(trace, "Optimize Vertices", size_t(36) * cpuModel.vertexCount + size_t(4) * cpuModel.indexCount, h2bPath);
+				H2B::Optimize(cpuModel, optimizeOptions, &optimizeReport);
+			}
+		}
+		LoadTimer timer(trace, "Meshlets & LODs", size_t(4) * GetIndexCount(), h2bPath);
+		LoadMeshlets();
+		LoadLods();
+		return true;
+	}
+
+	//Creates the vertex array, vertex buffer and index buffer of this mesh, does nothing if already uploaded
+	bool UploadToGPU() {
+		if (IsUploaded())
+			return true;
+		LoadTimer timer(trace, "Create GPU Buffers", GetUploadSize(), path);
+
+		if (compact) {
+			//Quantize the vertices against the mesh's bounds and upload the 16 byte versions
+			std::vector<H2B::COMPACT_VERTEX> compactVertices(GetVertexCount());
+			{
+				LoadTimer encodeTimer(trace, "Encode Compact Vertices", sizeof(H2B::VERTEX) * GetVertexCount(), path);
+				quantization = H2B::ComputeQuantization(GetVertices(), GetVertexCount());
+				H2B::EncodeCompactVertices(GetVertices(), GetVertexCount(), compactVertices.data(), quantization);
+			}
+			CreateVertexBuffer(compactVertices.data(), (sizeof(H2B::COMPACT_VERTEX) * GetVertexCount()), vertexArray, vertexBufferObject);
+		}
+		else {
+			//Create a Vertex Buffer (from a mapped file this is the only copy the data ever goes through)
+			CreateVertexBuffer(GetVertices(), (sizeof(H2B::VERTEX) * GetVertexCount()), vertexArray, vertexBufferObject);
+		}
+
+		//Create an Index Buffer, with 16 bit indices whenever every vertex can be addressed by them
+		//The simplified levels follow the file's own indices in the same buffer
+		const unsigned* indices = GetIndices();
+		unsigned indexCount = GetIndexCount();
+		std::vector<unsigned> allIndices;
+		if (!lods.indices.empty()) {
+			allIndices.reserve(size_t(indexCount) + lods.indices.size());
+			allIndices.assign(indices, indices + indexCount);
+			allIndices.insert(allIndices.end(), lods.indices.begin(), lods.indices.end());
+			indices = allIndices.data();
+			indexCount = static_cast<unsigned>(allIndices.size());
+		}
+		indexType = GL_UNSIGNED_INT;
+		std::vector<uint16_t> shortIndices;
+		if (H2B::IndicesFit16Bit(GetVertexCount())) {
+			shortIndices.resize(indexCount);
+			if (H2B::NarrowIndices16(indices, indexCount, shortIndices.data()))
+				indexType = GL_UNSIGNED_SHORT;
+		}
+		if (indexType == GL_UNSIGNED_SHORT)
+			CreateIndexBuffer(shortIndices.data(), (sizeof(uint16_t) * indexCount), indexBufferObject);
+		else
+			CreateIndexBuffer(indices, (sizeof(unsigned int) * indexCount), indexBufferObject);
+
+		//Establish Vertex Attribute Information
+		if (compact)
+			SetCompactVertexAttributes();
+		else
+			SetVertexAttributes();
+
+		//Return the GPU vertex array bind to 0, so Intel can display properly
+		glBindVertexArray(0);
+		return true;
+	}
+
+	//Frees the vertex array object, vertex buffer object and index buffer object of this mesh
+	void FreeResources() {
+		if (!IsUploaded())
+			return;
+		glDeleteVertexArrays(1, &vertexArray);
+		glDeleteBuffers(1, &vertexBufferObject);
+		glDeleteBuffers(1, &indexBufferObject);
+		vertexArray = vertexBufferObject = indexBufferObject = 0;
+	}
+
+private:
+	//Uses the meshlets stored in the file, or cuts them from the triangles in stored order if it has none
+	void LoadMeshlets() {
+		unsigned size = 0;
+		const char* stored = nullptr;
+		if (mapped)
+			stored = mappedModel.FindSection(H2B::SECTION_MESHLETS, size);
+		else if (const H2B::EXTRA_SECTION* section = cpuModel.FindSection(H2B::SECTION_MESHLETS)) {
+			stored = section->data.data();
+			size = static_cast<unsigned>(section->data.size());
+		}
+		if (!H2B::ReadMeshletSection(stored, size, GetIndexCount(), meshlets))
+			H2B::BuildMeshletsInOrder(GetVertices(), GetVertexCount(), GetIndices(), GetIndexCount(), GetMeshes(), meshlets);
+		H2B::GetMeshletRanges(meshlets, GetMeshes(), meshletRanges);
+	}
+
+	//Reads the simplified levels stored in the file
+	void LoadLods() {
+		unsigned size = 0;
+		const char* stored = nullptr;
+		if (mapped)
+			stored = mappedModel.FindSection(H2B::SECTION_LODS, size);
+		else if (const H2B::EXTRA_SECTION* section = cpuModel.FindSection(H2B::SECTION_LODS)) {
+			stored = section->data.data();
+			size = static_cast<unsigned>(section->data.size());
+		}
+		if (stored)
+			H2B::ReadLodSection(stored, size, GetVertexCount(), static_cast<unsigned>(GetMeshes().size()), lods);
+	}
+
+	//Helper Methods For UploadToGPU
+
+	//Creates a Vertex Buffer
+	//const void* data - The data to create a buffer for
+	//unsigned int sizeInBytes - The size of the parameter data in bytes
+	//GLuint& locVertexArray - The location of the vertex array
+	//GLuint& locVertexBufferObject - The location of the vertex buffer object
+	void CreateVertexBuffer(const void* data, unsigned int sizeInBytes, GLuint& locVertexArray, GLuint& locVertexBufferObject)
+	{
+		glGenVertexArrays(1, &locVertexArray);
+		glGenBuffers(1, &locVertexBufferObject);
+		glBindVertexArray(locVertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, locVertexBufferObject);
+		glBufferData(GL_ARRAY_BUFFER, sizeInBytes, data, GL_STATIC_DRAW);
+	}
+
+	//Creates a Index Buffer
+	//The index buffer is bound while the vertex array is bound, so the vertex array remembers it
+	//const void* data - The data to create a buffer for
+	//unsigned int sizeInBytes - The size of the parameter data in bytes
+	//GLuint& locIndexBufferObject - The location of the index buffer object
+	void CreateIndexBuffer(const void* data, unsigned int sizeInBytes, GLuint& locIndexBufferObject)
+	{
+		glGenBuffers(1, &locIndexBufferObject);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, locIndexBufferObject);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeInBytes, data, GL_STATIC_DRAW);
+	}
+
+	//Sets Vertex Attributes
+	//3 Vertex Attributes are bound by this function, for the Vertex's pos, uvw, and nrm variables
+	//VECTOR pos - The vertex's position
+	//VECTOR uvw - The vertex's uvw information
+	//VECTOR nrm - The vertex's normals
+	void SetVertexAttributes()
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, pos));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, uvw));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(H2B::VERTEX), (void*)offsetof(H2B::VERTEX, nrm));
+		glEnableVertexAttribArray(2);
+	}
+
+	//Sets Vertex Attributes for the compact layout (same locations, decoded by the vertex shader)
+	//GLushort pos[4] - Normalized position inside the mesh bounds (xyz used)
+	//GLushort uv[2] - Normalized uv inside the mesh's uv range
+	//GLshort nrm[2] - Octahedral encoded normal
+	void SetCompactVertexAttributes()
+	{
+		glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(H2B::COMPACT_VERTEX), (void*)offsetof(H2B::COMPACT_VERTEX, pos));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(H2B::COMPACT_VERTEX), (void*)offsetof(H2B::COMPACT_VERTEX, uv));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, sizeof(H2B::COMPACT_VERTEX), (void*)offsetof(H2B::COMPACT_VERTEX, nrm));
+		glEnableVertexAttribArray(2);
+	}
+};
+
+// Hands out shared MeshResources keyed by their resolved .h2b path
+class MeshCache {
+	// every mesh requested so far, a nullptr entry remembers a path that failed to load
+	std::unordered_map<std::string, std::shared_ptr<MeshResource>> meshes;
+	// load new meshes through H2B::MappedParser instead of H2B::Parser
+	bool useMappedFiles = false;
+	// upload new meshes with 16 byte quantized vertices
+	bool useCompactVertices = false;
+	// passes run over new meshes after parsing
+	H2B::OPTIMIZE_OPTIONS optimizeOptions;
+	// handed to new meshes to record their load phases in
+	LoadTrace* trace = nullptr;
+
+public:
+	//Chooses how meshes loaded from now on are read
+	//bool enable - true maps .h2b files and reads them in place (zero-copy), false copies them through H2B::Parser
+	inline void SetMappedFiles(bool enable) {
+		useMappedFiles = enable;
+	}
+
+	//Chooses the vertex layout of meshes loaded from now on
+	//bool enable - true for 16 byte quantized vertices, false for 36 byte float vertices
+	inline void SetCompactVertices(bool enable) {
+		useCompactVertices = enable;
+	}
+
+	//Chooses the optimization passes run over meshes loaded from now on
+	//const H2B::OPTIMIZE_OPTIONS& options - Passes to run (forces copied loading while any is enabled)
+	inline void SetOptimizeOptions(const H2B::OPTIMIZE_OPTIONS& options) {
+		optimizeOptions = options;
+	}
+
+	//Chooses where meshes loaded from now on record their load phases
+	//LoadTrace* loadTrace - nullptr records nothing
+	inline void SetLoadTrace(LoadTrace* loadTrace) {
+		trace = loadTrace;
+	}
+
+	//Returns the LoadTrace meshes record in (nullptr for none)
+	inline LoadTrace* GetLoadTrace() const {
+		return trace;
+	}
+
+	//Returns the shared mesh for a .h2b file, parsing it only the first time it is requested
+	//Returns nullptr if the file could not be loaded (the failure is cached as well)
+	//const std::string& h2bPath - The resolved path of the .h2b file
+	//bool* wasCached - Optional, set to true if no parse was needed
+	std::shared_ptr<MeshResource> Acquire(const std::string& h2bPath, bool* wasCached = nullptr) {
+		auto found = meshes.find(h2bPath);
+		if (wasCached)
+			*wasCached = (found != meshes.end());
+		if (found != meshes.end())
+			return found->second;
+
+		auto mesh = std::make_shared<MeshResource>();
+		mesh->SetCompactVertices(useCompactVertices);
+		mesh->SetOptimizeOptions(optimizeOptions);
+		mesh->SetLoadTrace(trace);
+		if (!mesh->LoadFromDisk(h2bPath, useMappedFiles))
+			mesh = nullptr;
+		meshes.emplace(h2bPath, mesh);
+		return mesh;
+	}
+
+	//Returns true if the .h2b file was already requested (whether or not it loaded)
+	//const std::string& h2bPath - The resolved path of the .h2b file
+	inline bool Contains(const std::string& h2bPath) const {
+		return meshes.find(h2bPath) != meshes.end();
+	}
+
+	//Parses every .h2b file not cached yet at the same time, so the Acquire calls for them that follow don't have to
+	//Files only touch their own MeshResource while parsing, the cache itself is filled afterwards in the given order
+	//const std::vector<std::string>& h2bPaths - The resolved paths of the .h2b files (duplicates are loaded once)
+	//ThreadPool* pool - Workers to parse on (the calling thread helps), nullptr parses one file after the other
+	void Preload(const std::vector<std::string>& h2bPaths, ThreadPool* pool) {
+		std::vector<std::string> pending;
+		for (auto& h2bPath : h2bPaths)
+			if (!Contains(h2bPath) && std::find(pending.begin(), pending.end(), h2bPath) == pending.end())
+				pending.push_back(h2bPath);
+		std::vector<std::shared_ptr<MeshResource>> loaded(pending.size());
+		auto load = [&](size_t i) {
+			auto mesh = std::make_shared<MeshResource>();
+			mesh->SetCompactVertices(useCompactVertices);
+			mesh->SetOptimizeOptions(optimizeOptions);
+			mesh->SetLoadTrace(trace);
+			if (mesh->LoadFromDisk(pending[i], useMappedFiles))
+				loaded[i] = std::move(mesh);
+		};
+		if (pool)
+			pool->ParallelFor(pending.size(), load);
+		else
+			for (size_t i = 0; i < pending.size(); ++i)
+				load(i);
+		for (size_t i = 0; i < pending.size(); ++i)
+			meshes.emplace(pending[i], std::move(loaded[i]));
+	}
+
+	//Uploads every cached mesh that is not in VRAM yet
+	void UploadAllToGPU() {
+		for (auto& e : meshes)
+			if (e.second)
+				e.second->UploadToGPU();
+	}
+
+	//Uploads cached meshes that are not in VRAM yet until about byteBudget bytes were sent, at least one mesh per call
+	//Returns true once every mesh is uploaded, call it again (next frame) while it returns false
+	//size_t byteBudget - Bytes to upload in this call, a mesh is never split so one larger than this goes alone
+	bool UploadSomeToGPU(size_t byteBudget) {
+		size_t sent = 0;
+		for (auto& e : meshes) {
+			if (!e.second || e.second->IsUploaded())
+				continue;
+			size_t size = e.second->GetUploadSize();
+			if (sent > 0 && sent + size > byteBudget)
+				return false;
+			e.second->UploadToGPU();
+			sent += size;
+		}
+		return true;
+	}
+
+	//Adds up the RAM & VRAM held by the cached meshes
+	//size_t& cpuBytes - Receives the bytes of CPU data (see MeshResource::GetCpuSize)
+	//size_t& gpuBytes - Receives the bytes of GPU buffers (see MeshResource::GetGpuSize)
+	void GetMemoryUsage(size_t& cpuBytes, size_t& gpuBytes) const {
+		cpuBytes = gpuBytes = 0;
+		for (auto& e : meshes)
+			if (e.second) {
+				cpuBytes += e.second->GetCpuSize();
+				gpuBytes += e.second->GetGpuSize();
+			}
+	}
+
+	//Exchanges the meshes of two caches, the load settings of each cache stay as they were
+	void SwapMeshes(MeshCache& other) {
+		meshes.swap(other.meshes);
+	}
+
+	//Copies how another cache loads & uploads meshes
+	void CopySettings(const MeshCache& other) {
+		useMappedFiles = other.useMappedFiles;
+		useCompactVertices = other.useCompactVertices;
+		optimizeOptions = other.optimizeOptions;
+		trace = other.trace;
+	}
+
+	//Releases every mesh that is no longer referenced outside of the cache
+	void Trim() {
+		for (auto it = meshes.begin(); it != meshes.end();) {
+			if (it->second == nullptr || it->second.use_count() == 1)
+				it = meshes.erase(it);
+			else
+				++it;
+		}
+	}
+
+	//Releases the cache's references to all meshes (GPU data is freed with the last reference)
+	void Clear() {
+		meshes.clear();
+	}
+
+	//Returns the number of unique meshes that loaded successfully
+	size_t Size() const {
+		size_t count = 0;
+		for (auto& e : meshes)
+			if (e.second)
+				++count;
+		return count;
+	}
+};
+#endif
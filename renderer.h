@@ -5,6 +5,7 @@
 //Parser Includes
 #include "h2bParser.h"
 #include "load_object_oriented.h"
+#include "level_switcher.h"
 //IMGUI includes
 #include "Libraries/IMGUI/imgui.h"
 #include "Libraries/IMGUI/imgui_impl_win32.h"
@@ -19,6 +20,81 @@
 #define LEVEL_FOUR_RELEASED 0
 #define LEVEL_FIVE_RELEASED 0
 
+//define to determine how .h2b files are read
+//0 -> Copied into CPU buffers by H2B::Parser
+//1 -> Memory mapped, vertices/indices go straight from the file mapping to the GPU
+#define USE_MAPPED_H2B_FILES 1
+
+//define to determine the vertex layout uploaded to the GPU
+//0 -> 36 byte float vertices (H2B::VERTEX)
+//1 -> 16 byte quantized vertices (H2B::COMPACT_VERTEX), decoded in the vertex shader
+#define USE_COMPACT_VERTICES 1
+
+//define to determine whether meshes are welded, reordered for the vertex cache, overdraw & vertex fetch and simplified while loading
+//0 -> Draw the indices as stored (run Tools/h2bCook offline to get the same result with zero-copy loading)
+//1 -> Reorder every mesh at load time, this copies the meshes even when USE_MAPPED_H2B_FILES is 1
+#define OPTIMIZE_MESHES_ON_LOAD 0
+
+//define to determine how meshlets are culled before drawing
+//0 -> Every mesh is drawn whole
+//1 -> Meshlets outside the view frustum are skipped
+//2 -> Meshlets outside the view frustum or facing away from the camera are skipped (counter clockwise front faces)
+#define USE_CLUSTER_CULLING 2
+
+//define to determine when simplified levels of detail (stored in the .h2b files by Tools/h2bCook --lods) are drawn
+//0 -> Always draw full detail
+//n -> Draw the coarsest level whose error stays under n pixels on screen
+#define LOD_PIXEL_ERROR 1.0f
+
+//define to determine how many threads parse a level's .h2b files while it loads
+//0 -> One per hardware thread
+//1 -> Parse one file after the other on the main thread
+//n -> n threads
+#define LOAD_THREADS 0
+
+//define to determine which file a level is read from
+//0 -> Always parse GameLevel.txt
+//1 -> Map GameLevel.h2l (written by Tools/levelCook) when it is at least as new as GameLevel.txt, else parse the text
+#define USE_COMPILED_SCENES 1
+
+//define to determine how picking a level in the menu switches to it
+//0 -> Unload, load & upload the new level inside one frame (the window freezes while it loads)
+//1 -> Load it on background threads while the current level keeps drawing, upload it a slice per frame, then swap it in
+#define ASYNC_LEVEL_SWITCH 1
+
+//define to determine about how many bytes of a level loaded in the background are uploaded to the GPU per frame
+#define LEVEL_UPLOAD_BYTES_PER_FRAME (2 * 1024 * 1024)
+
+//defines to determine which levels stay loaded (CPU & GPU) after being switched away from, so switching back is instant
+//RESIDENT_LEVELS -> Most levels kept besides the one on screen (0 frees a level as soon as it leaves the screen)
+//RESIDENT_RAM_BUDGET_MB / RESIDENT_VRAM_BUDGET_MB -> Memory the kept levels may hold together, least recently used go first
+//PREFETCH_ADJACENT_LEVEL -> 1 loads the level after the current one in the level select list in the background while idle
+#define RESIDENT_LEVELS 2
+#define RESIDENT_RAM_BUDGET_MB 256
+#define RESIDENT_VRAM_BUDGET_MB 128
+#define PREFETCH_ADJACENT_LEVEL 1
+
+//defines to determine how the view is cut into froxels for the level's lights (each fragment shades the point & spot lights of its froxel)
+//LIGHT_GRID_TILES_X / LIGHT_GRID_TILES_Y -> Screen tiles across & down
+//LIGHT_GRID_SLICES -> Depth slices from the near to the far plane, growing with distance (1, 1, 1 shades every light everywhere)
+//LIGHT_RANGE -> Distance at which point & spot lights fade out (the level exporter doesn't write one)
+#define LIGHT_GRID_TILES_X 16
+#define LIGHT_GRID_TILES_Y 9
+#define LIGHT_GRID_SLICES 24
+#define LIGHT_RANGE 8.0f
+
+//define to determine which log messages are written (ASYNC_LOG_VERBOSITY, set for the build, removes the ones above it from the code)
+//LOG_ERROR -> Errors only
+//LOG_WARNING / LOG_EVENT / LOG_MESSAGE -> Each adds its category to the ones before
+//LOG_INFO -> Everything, every model, light & file of a level included
+#define LOG_VERBOSITY LOG_INFO
+
+//defines to determine whether the phases of every level load (parse, resolve, read, decode, vertex processing, GPU buffers, shaders) are timed
+//0 -> No timing
+//1 -> Timed, written as a Chrome trace (open in chrome://tracing or ui.perfetto.dev) to LOAD_TRACE_FILE after each load
+#define LOAD_TRACE 1
+#define LOAD_TRACE_FILE "../LevelLoaderTrace.json"
+
 //Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -75,6 +151,7 @@ class Renderer
 
 	//Level Info
 	unsigned int level = 0; //int to store the value of the level currently being rendered
+	static constexpr unsigned int LEVEL_COUNT = 5; //Number of slots in the level select list
 	bool show_window = false; //Bool to keep track of whether the IMGUI window should be visible/interactable
 	bool levelChanged = false; //Bool to keep track of if the level needs to be re-rendered
 	float plevelState = 0.0f; //Float buffer for toggling window visibility
@@ -82,7 +159,7 @@ class Renderer
 	//Proxy Handles
 	GW::SYSTEM::GWindow win;
 	GW::GRAPHICS::GOpenGLSurface ogl;
-	GW::SYSTEM::GLog log;
+	AsyncLog log;
 	GW::MATH::GMatrix mat_proxy;
 
 	//Triangle Info
@@ -112,7 +189,10 @@ class Renderer
 	GW::INPUT::GInput input;
 	GW::INPUT::GController controller;
 
+	LoadTrace loadTrace; //Time spent in each phase of loading (LOAD_TRACE), written next to the log, outlives the levels loading into it
 	Level_Objects models;
+	LevelSwitcher levelSwitcher; //Loads the level picked in the menu in the background (ASYNC_LEVEL_SWITCH)
+	RENDER_STATS mainViewStats; //What the main view drew last frame
 
 	//Dear IMGUI Information
 	//Courtesy of IMGUI examples in API_SAMPLES
@@ -153,6 +233,13 @@ class Renderer
 				}
 				ImGui::EndPopup();
 			}			
+			ImGui::Text("Triangles: %zu / %zu (%zu draws)", mainViewStats.drawnTriangles, mainViewStats.totalTriangles, mainViewStats.drawCalls);
+			ImGui::Text("Lights: %zu (%zu in froxels)", mainViewStats.lights, mainViewStats.lightAssignments);
+			if (levelSwitcher.IsSwitching())
+				ImGui::Text("Loading %s...", levelSwitcher.GetLoadingPath().c_str());
+			size_t residentRam = 0, residentVram = 0;
+			levelSwitcher.GetResidentMemory(residentRam, residentVram);
+			ImGui::Text("Resident levels: %zu (%.1f MB RAM, %.1f MB VRAM)", levelSwitcher.GetResidentCount(), residentRam / 1048576.0, residentVram / 1048576.0);
 		}
 		//Rendering
 		ImGui::Render();
@@ -160,12 +247,13 @@ class Renderer
 		ImGui::EndFrame();
 	}
 public:
-	Renderer(GW::SYSTEM::GWindow _win, GW::GRAPHICS::GOpenGLSurface _ogl, GW::SYSTEM::GLog _log)
+	Renderer(GW::SYSTEM::GWindow _win, GW::GRAPHICS::GOpenGLSurface _ogl, AsyncLog _log)
 	{
 		//Attach Global & Parameter values
 		win = _win;
 		ogl = _ogl;
 		log = _log;
+		log.SetVerbosity(LOG_VERBOSITY);
 
 		//Create Universal Window Handler
 		GW::SYSTEM::UNIVERSAL_WINDOW_HANDLE uwh;
@@ -218,16 +306,34 @@ public:
 		GW::MATH::GVector::NormalizeF(dirLight, dirLight); //Normalizes the dirLight
 		GW::MATH::GVECTORF dirLightColor = { 0.9f, 0.9f, 1.0f, 1.0f }; //RGBA
 
-		shaderMats.sunDirection = dirLight; //Set sunDirection to dirLight (previously created) (read from file?)
-		shaderMats.sunColor = dirLightColor; //Set sunColor to dirLightColor (previously created) (read from file?)
+		shaderMats.sunDirection = dirLight; //Set sunDirection to dirLight (previously created)
+		shaderMats.sunColor = dirLightColor; //Set sunColor to dirLightColor (previously created)
 		shaderMats.sunAmbient = { 0.25f, 0.25f, 0.35f, 1 }; //Set sunAmbient (ambient lighting) to a specified set of values
 
+		//Level Lights (LIGHT blocks of the GameLevel), the sun above lights levels that have no Sun of their own
+		LIGHT_DEFAULTS lightDefaults;
+		std::memcpy(lightDefaults.sunDirection, dirLight.data, sizeof(lightDefaults.sunDirection));
+		std::memcpy(lightDefaults.sunColor, dirLightColor.data, sizeof(lightDefaults.sunColor));
+		lightDefaults.pointRange = LIGHT_RANGE;
+
 		//h2b Parser initialization
-		
+		models.SetMappedLoading(USE_MAPPED_H2B_FILES == 1);
+		models.SetCompactVertices(USE_COMPACT_VERTICES == 1);
+		models.SetLoadTimeOptimization(OPTIMIZE_MESHES_ON_LOAD == 1);
+		models.SetClusterCulling(USE_CLUSTER_CULLING);
+		models.SetLodPixelError(LOD_PIXEL_ERROR);
+		models.SetLoadThreads(LOAD_THREADS);
+		models.SetCompiledScenes(USE_COMPILED_SCENES == 1);
+		models.SetLightDefaults(lightDefaults);
+		models.SetLightGridSize(LIGHT_GRID_TILES_X, LIGHT_GRID_TILES_Y, LIGHT_GRID_SLICES);
+		models.SetLoadTrace(GetLoadTrace());
 		models.LoadLevel("../Assets/Level2/GameLevel.txt", "../Assets/Level2/Models", log); //Load the default level
 		models.UploadLevelToGPU(); //Upload the information to the system
+		levelSwitcher.SetOnScreen("../Assets/Level2/GameLevel.txt");
+		levelSwitcher.SetResidency(RESIDENT_LEVELS, size_t(RESIDENT_RAM_BUDGET_MB) << 20, size_t(RESIDENT_VRAM_BUDGET_MB) << 20);
 
 		InitializeGraphics();
+		WriteLoadTrace();
 
 		//Dear IMGUI Information 
 		IMGUI_CHECKVERSION();
@@ -250,11 +356,25 @@ private:
 		BindDebugCallback(); // In debug mode we link openGL errors to the console
 #endif
 		CreateUBOBuffer(&shaderMats, sizeof(SCENE_DATA), UBO);
+		LoadTimer timer(GetLoadTrace(), "Compile Shaders");
 		CompileVertexShader();
 		CompileFragmentShader();
 		CreateExecutableShaderProgram();
 	}
 
+	//Returns where level loads record their phases, nullptr when LOAD_TRACE is off
+	LoadTrace* GetLoadTrace()
+	{
+		return LOAD_TRACE == 1 ? &loadTrace : nullptr;
+	}
+
+	//Writes every load phase timed so far to LOAD_TRACE_FILE
+	void WriteLoadTrace()
+	{
+		if (LOAD_TRACE == 1 && !loadTrace.Write(LOAD_TRACE_FILE))
+			log.Write<LOG_WARNING>("Load trace could not be written to %s", LOAD_TRACE_FILE);
+	}
+
 #ifndef NDEBUG
 	void BindDebugCallback()
 	{
@@ -358,27 +478,61 @@ public:
 				std::cout << levelChange << " - " << plevelState << "\n";
 			}
 		}
+		const char* gameLevelPath = nullptr;
+		const char* h2bFolderPath = nullptr;
 		if (levelChanged) //If the level has changed
 		{
+#if ASYNC_LEVEL_SWITCH == 1
+			//Keep drawing the current level until the new one is ready (a resident level is swapped in right away)
+			if (GetLevelPaths(level, gameLevelPath, h2bFolderPath))
+				levelSwitcher.Request(gameLevelPath, h2bFolderPath, models, log);
+#else
 			//Unload the current level
 			models.UnloadLevel();
-			switch (level) //Check which level needs to be loaded, and load the corresponding level
-			{
-			case 0:
-				if(LEVEL_ONE_RELEASED == 1)
-				models.LoadLevel("../Assets/Level1/GameLevel.txt", "../Assets/Level1/Models", log);
-				break;
-			case 1:
-				models.LoadLevel("../Assets/Level2/GameLevel.txt", "../Assets/Level2/Models", log);
-				break;
-			//If a level is selected that doesn't have anything to switch to, load the default level (level 1)
-			default:
-				models.LoadLevel("../Assets/Level1/GameLevel.txt", "../Assets/Level1/Models", log);
-				break;
+			if (GetLevelPaths(level, gameLevelPath, h2bFolderPath)) {
+				models.LoadLevel(gameLevelPath, h2bFolderPath, log);
+				levelSwitcher.SetOnScreen(gameLevelPath);
 			}
 			models.UploadLevelToGPU();
+			WriteLoadTrace();
+#endif
 			levelChanged = false; //Reset the flag
 		}
+		//Upload a slice of a level loaded in the background, swapping it in once it is all on the GPU
+		if (levelSwitcher.Update(models, LEVEL_UPLOAD_BYTES_PER_FRAME))
+			WriteLoadTrace();
+#if ASYNC_LEVEL_SWITCH == 1 && PREFETCH_ADJACENT_LEVEL == 1
+		//While nothing is loading, warm up the next level in the list that isn't the one on screen
+		for (unsigned int next = 1; next < LEVEL_COUNT && !levelSwitcher.IsBusy(); ++next)
+			if (GetLevelPaths((level + next) % LEVEL_COUNT, gameLevelPath, h2bFolderPath) && levelSwitcher.GetOnScreenPath() != gameLevelPath) {
+				levelSwitcher.Prefetch(gameLevelPath, h2bFolderPath, models, log);
+				break;
+			}
+#endif
+	}
+
+	//Finds the files of a level in the level select list, returns false if the slot has nothing to load
+	//unsigned int index - Slot in the list (0 is Level 1)
+	bool GetLevelPaths(unsigned int index, const char*& gameLevelPath, const char*& h2bFolderPath)
+	{
+		switch (index) //Check which level needs to be loaded, and load the corresponding level
+		{
+		case 0:
+			if (LEVEL_ONE_RELEASED != 1)
+				return false;
+			gameLevelPath = "../Assets/Level1/GameLevel.txt";
+			h2bFolderPath = "../Assets/Level1/Models";
+			return true;
+		case 1:
+			gameLevelPath = "../Assets/Level2/GameLevel.txt";
+			h2bFolderPath = "../Assets/Level2/Models";
+			return true;
+		//If a level is selected that doesn't have anything to switch to, load the default level (level 1)
+		default:
+			gameLevelPath = "../Assets/Level1/GameLevel.txt";
+			h2bFolderPath = "../Assets/Level1/Models";
+			return true;
+		}
 	}
 
 	void UpdateCamera()
@@ -508,7 +662,8 @@ public:
 		glBindBuffer(GL_UNIFORM_BUFFER, UBO); //Bind the SCENE_DATA UBO for editing
 		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SCENE_DATA), &shaderMats); //Edit the SCENE_DATA UBO to the newly adjusted camera value (which will be the only thing that changes on this side)
 
-		models.RenderLevel(shaderExecutable); //Renders the level
+		models.RenderLevel(shaderExecutable, shaderMats.viewMatrix, shaderMats.projectionMatrix, shaderMats.cameraPos, (float)height); //Renders the level
+		mainViewStats = models.GetRenderStats(); //Keep the main view's culling results for the menu
 
 		//Rudimentary minimap
 		glViewport((GLsizei)width / 2, (GLsizei)height / 2, (GLsizei)width/2, (GLsizei)height /2);
@@ -528,7 +683,7 @@ public:
 		glBufferSubData(GL_UNIFORM_BUFFER, ((sizeof(GW::MATH::GVECTORF) * 2) + (sizeof(GW::MATH::GMATRIXF) * 2)), sizeof(GW::MATH::GVECTORF), (void*) & minimapMats.cameraPos); //Substitute the mm camera pos for the normal camera pos
 		//glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SCENE_DATA), &minimapMats);
 
-		models.RenderLevel(shaderExecutable); //Render the level
+		models.RenderLevel(shaderExecutable, minimapMats.viewMatrix, shaderMats.projectionMatrix, minimapMats.cameraPos, (float)height / 2); //Render the level
 		
 		startProgram(0); // some video cards(cough Intel) need this set back to zero or they won't display
 		
@@ -546,6 +701,7 @@ public:
 	~Renderer()
 	{
 		models.UnloadLevel(); //Destroys all instances created by LoadLevel()
+		WriteLoadTrace(); //Prefetched levels included
 	}
 };
 
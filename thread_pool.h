@@ -0,0 +1,125 @@
+// Fixed set of worker threads that run queued jobs.
+// Used to parse a level's .h2b files side by side, the thread that waits on the jobs helps run them.
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+	std::vector<std::thread> workers;
+	// jobs waiting for a worker
+	std::queue<std::function<void()>> jobs;
+	std::mutex jobsLock;
+	std::condition_variable jobsReady;
+	bool stopping = false;
+
+	// Runs jobs until the pool is destroyed
+	void WorkerLoop() {
+		for (;;) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(jobsLock);
+				jobsReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+				if (stopping && jobs.empty())
+					return;
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+			job();
+		}
+	}
+
+public:
+	//Starts the worker threads
+	//unsigned threadCount - Number of workers, 0 uses one per hardware thread minus the caller's
+	explicit ThreadPool(unsigned threadCount = 0) {
+		if (threadCount == 0) {
+			unsigned hardware = std::thread::hardware_concurrency();
+			threadCount = hardware > 1 ? hardware - 1 : 1;
+		}
+		workers.reserve(threadCount);
+		for (unsigned i = 0; i < threadCount; ++i)
+			workers.emplace_back([this] { WorkerLoop(); });
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	// Finishes every queued job, then joins the workers
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(jobsLock);
+			stopping = true;
+		}
+		jobsReady.notify_all();
+		for (auto& w : workers)
+			w.join();
+	}
+
+	//Returns the number of worker threads
+	inline unsigned GetThreadCount() const {
+		return static_cast<unsigned>(workers.size());
+	}
+
+	//Queues a job and returns a future for its result (exceptions thrown by the job are rethrown by future::get)
+	template <typename Function>
+	auto Submit(Function job) -> std::future<decltype(job())> {
+		auto task = std::make_shared<std::packaged_task<decltype(job())()>>(std::move(job));
+		std::future<decltype(job())> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(jobsLock);
+			jobs.emplace([task] { (*task)(); });
+		}
+		jobsReady.notify_one();
+		return result;
+	}
+
+	//Calls job(i) for every i in [0, count) across the workers and the calling thread, returns when all calls are done
+	//The first exception thrown by a call stops the remaining items and is rethrown here
+	//Items are handed out one at a time, so uneven items (big and small files) still balance
+	//size_t count - Number of items
+	//Function job - Called as job(size_t index), must be safe to run concurrently for different indices
+	template <typename Function>
+	void ParallelFor(size_t count, Function job) {
+		if (count == 0)
+			return;
+		std::atomic<size_t> next{ 0 };
+		auto run = [&] {
+			for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+				job(i);
+		};
+		size_t helpers = std::min<size_t>(workers.size(), count - 1);
+		std::vector<std::future<void>> running;
+		running.reserve(helpers);
+		for (size_t h = 0; h < helpers; ++h)
+			running.push_back(Submit(run));
+		// every helper must be done with next & job before they go out of scope, even if one of the calls threw
+		std::exception_ptr error;
+		try {
+			run();
+		}
+		catch (...) {
+			error = std::current_exception();
+			next = count;
+		}
+		for (auto& r : running) {
+			try {
+				r.get();
+			}
+			catch (...) {
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+		if (error)
+			std::rethrow_exception(error);
+	}
+};
+#endif
@@ -0,0 +1,263 @@
+// Parent / child transforms of a level's models (a MovingPlatform carrying its crates).
+// Nodes are kept in depth first order in flat arrays, so every parent comes before its children and every subtree is
+// one contiguous range [p, p + subtreeSizes[p]). Update only walks the ranges under nodes whose local matrix changed,
+// multiplying local * parent world front to back with SSE2: a level where nothing moves costs nothing, a moving
+// subtree costs its size. Nodes are named by the id Add returned, ids stay the same when the order is rebuilt.
+#ifndef _TRANSFORM_HIERARCHY_H_
+#define _TRANSFORM_HIERARCHY_H_
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "h2bSimd.h"
+
+class TransformHierarchy {
+	// by position (depth first order)
+	std::vector<GW::MATH::GMATRIXF> locals; // relative to the parent, the world matrix for roots
+	std::vector<GW::MATH::GMATRIXF> worlds;
+	std::vector<int> parents; // position of the parent, -1 for roots
+	std::vector<unsigned> subtreeSizes; // the node & everything under it
+	std::vector<unsigned> nodeAt; // position -> id
+	std::vector<unsigned char> dirty; // local matrix changed since the last Update
+	// by id
+	std::vector<unsigned> positionOf;
+	std::vector<int> parentIds; // -1 for roots
+	// positions whose local matrix changed since the last Update
+	std::vector<unsigned> dirtyRoots;
+	// ids Update recomputed, in position order
+	std::vector<unsigned> changed;
+	// Add or SetParent broke the depth first order, the next Update rebuilds it
+	bool reorder = false;
+
+	// out = a * b for row major affine matrices (row vectors: p * a * b), out may not alias b
+	static void Multiply(const float* a, const float* b, float* out) {
+#if H2B_SIMD_SSE2
+		__m128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+		for (int r = 0; r < 4; ++r) {
+			__m128 row = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[r * 4 + 0]), b0), _mm_mul_ps(_mm_set1_ps(a[r * 4 + 1]), b1)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[r * 4 + 2]), b2), _mm_mul_ps(_mm_set1_ps(a[r * 4 + 3]), b3)));
+			_mm_storeu_ps(out + r * 4, row);
+		}
+#else
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				out[r * 4 + c] = a[r * 4 + 0] * b[0 * 4 + c] + a[r * 4 + 1] * b[1 * 4 + c] + a[r * 4 + 2] * b[2 * 4 + c] + a[r * 4 + 3] * b[3 * 4 + c];
+#endif
+	}
+
+	// Inverts a row major affine matrix (last column 0, 0, 0, 1), false if its 3x3 part is flat
+	static bool InvertAffine(const float* m, float* out) {
+		float c00 = m[5] * m[10] - m[6] * m[9], c01 = m[6] * m[8] - m[4] * m[10], c02 = m[4] * m[9] - m[5] * m[8];
+		float determinant = m[0] * c00 + m[1] * c01 + m[2] * c02;
+		if (determinant == 0)
+			return false;
+		float inverse = 1.0f / determinant;
+		float i[16] = {
+			c00 * inverse, (m[2] * m[9] - m[1] * m[10]) * inverse, (m[1] * m[6] - m[2] * m[5]) * inverse, 0,
+			c01 * inverse, (m[0] * m[10] - m[2] * m[8]) * inverse, (m[2] * m[4] - m[0] * m[6]) * inverse, 0,
+			c02 * inverse, (m[1] * m[8] - m[0] * m[9]) * inverse, (m[0] * m[5] - m[1] * m[4]) * inverse, 0,
+			0, 0, 0, 1 };
+		// the translation moves back through the inverted 3x3 part
+		for (int k = 0; k < 3; ++k)
+			i[12 + k] = -(m[12] * i[0 * 4 + k] + m[13] * i[1 * 4 + k] + m[14] * i[2 * 4 + k]);
+		std::memcpy(out, i, sizeof(i));
+		return true;
+	}
+
+	// Marks a position for the next Update
+	void MarkDirty(unsigned p) {
+		if (!dirty[p]) {
+			dirty[p] = 1;
+			dirtyRoots.push_back(p);
+		}
+	}
+
+	// Rebuilds the depth first order from parentIds (roots & siblings by id), dirty nodes stay dirty
+	void Reorder() {
+		size_t count = positionOf.size();
+		// children of each id, counting sorted so siblings stay in id order
+		std::vector<unsigned> firstChild(count + 1, 0), children(count);
+		for (int parent : parentIds)
+			if (parent >= 0)
+				++firstChild[parent + 1];
+		for (size_t i = 0; i < count; ++i)
+			firstChild[i + 1] += firstChild[i];
+		std::vector<unsigned> filled(firstChild.begin(), firstChild.end() - 1);
+		for (size_t i = 0; i < count; ++i)
+			if (parentIds[i] >= 0)
+				children[filled[parentIds[i]]++] = static_cast<unsigned>(i);
+		// depth first walk with an explicit stack, children pushed in reverse so the first one comes out first
+		std::vector<unsigned> order, stack;
+		order.reserve(count);
+		for (size_t root = 0; root < count; ++root) {
+			if (parentIds[root] >= 0)
+				continue;
+			stack.push_back(static_cast<unsigned>(root));
+			while (!stack.empty()) {
+				unsigned id = stack.back();
+				stack.pop_back();
+				order.push_back(id);
+				for (unsigned c = firstChild[id + 1]; c > firstChild[id]; --c)
+					stack.push_back(children[c - 1]);
+			}
+		}
+		std::vector<GW::MATH::GMATRIXF> sortedLocals(count), sortedWorlds(count);
+		std::vector<unsigned char> sortedDirty(count);
+		for (size_t p = 0; p < count; ++p) {
+			sortedLocals[p] = locals[positionOf[order[p]]];
+			sortedWorlds[p] = worlds[positionOf[order[p]]];
+			sortedDirty[p] = dirty[positionOf[order[p]]];
+		}
+		locals.swap(sortedLocals);
+		worlds.swap(sortedWorlds);
+		dirty.swap(sortedDirty);
+		nodeAt.swap(order);
+		for (size_t p = 0; p < count; ++p)
+			positionOf[nodeAt[p]] = static_cast<unsigned>(p);
+		// subtree sizes back to front, every child comes after its parent
+		std::fill(subtreeSizes.begin(), subtreeSizes.end(), 1u);
+		for (size_t p = count; p-- > 0;) {
+			int parent = parentIds[nodeAt[p]];
+			parents[p] = parent >= 0 ? static_cast<int>(positionOf[parent]) : -1;
+			if (parent >= 0)
+				subtreeSizes[parents[p]] += subtreeSizes[p];
+		}
+		dirtyRoots.clear();
+		for (size_t p = 0; p < count; ++p)
+			if (dirty[p])
+				dirtyRoots.push_back(static_cast<unsigned>(p));
+		reorder = false;
+	}
+
+public:
+	//Adds a node
+	//Returns its id (ids count up from 0)
+	//const float* local - 4x4 row major matrix relative to the parent (the world matrix of a root)
+	//int parent - Id of the parent, -1 for a root
+	unsigned Add(const float* local, int parent = -1) {
+		unsigned id = static_cast<unsigned>(positionOf.size());
+		unsigned p = static_cast<unsigned>(locals.size());
+		GW::MATH::GMATRIXF matrix;
+		std::memcpy(matrix.data, local, sizeof(matrix.data));
+		locals.push_back(matrix);
+		worlds.push_back(matrix);
+		parents.push_back(parent >= 0 ? static_cast<int>(positionOf[parent]) : -1);
+		subtreeSizes.push_back(1);
+		nodeAt.push_back(id);
+		dirty.push_back(0);
+		positionOf.push_back(p);
+		parentIds.push_back(parent);
+		// a root (or the last node's child) at the end keeps the order, any other child is sorted in by the next Update
+		reorder = reorder || (parent >= 0 && positionOf[parent] + subtreeSizes[positionOf[parent]] != p);
+		if (!reorder)
+			for (int a = parents[p]; a >= 0; a = parents[a])
+				++subtreeSizes[a];
+		MarkDirty(p);
+		return id;
+	}
+
+	//Moves a node (with everything under it) under another node, keeping its world matrix as of the last Update
+	//Returns false if the new parent is the node itself or under it
+	//unsigned node - Id of the node to move
+	//int parent - Id of the new parent, -1 makes the node a root
+	bool SetParent(unsigned node, int parent) {
+		for (int a = parent; a >= 0; a = parentIds[a])
+			if (static_cast<unsigned>(a) == node)
+				return false;
+		if (parentIds[node] == parent)
+			return true;
+		unsigned p = positionOf[node];
+		GW::MATH::GMATRIXF local = worlds[p];
+		float inverse[16];
+		if (parent >= 0 && InvertAffine(worlds[positionOf[parent]].data, inverse))
+			Multiply(worlds[p].data, inverse, local.data);
+		locals[p] = local;
+		parentIds[node] = parent;
+		MarkDirty(p);
+		reorder = true;
+		return true;
+	}
+
+	//Changes the matrix of a node relative to its parent, its world matrix (& those under it) follow on the next Update
+	//unsigned node - Id returned by Add
+	//const float* local - 4x4 row major matrix
+	void SetLocalMatrix(unsigned node, const float* local) {
+		unsigned p = positionOf[node];
+		std::memcpy(locals[p].data, local, sizeof(locals[p].data));
+		MarkDirty(p);
+	}
+
+	//Returns the matrix of a node relative to its parent
+	inline const GW::MATH::GMATRIXF& GetLocalMatrix(unsigned node) const {
+		return locals[positionOf[node]];
+	}
+
+	//Returns the world matrix of a node as of the last Update
+	inline const GW::MATH::GMATRIXF& GetWorldMatrix(unsigned node) const {
+		return worlds[positionOf[node]];
+	}
+
+	//Returns the id of a node's parent, -1 for a root
+	inline int GetParent(unsigned node) const {
+		return parentIds[node];
+	}
+
+	//Recomputes the world matrices under every node whose local matrix (or parent) changed, nothing else is read
+	//Returns the number of world matrices recomputed (see GetChanged)
+	size_t Update() {
+		changed.clear();
+		if (reorder)
+			Reorder();
+		if (dirtyRoots.empty())
+			return 0;
+		// front to back, a subtree inside one already done is skipped
+		std::sort(dirtyRoots.begin(), dirtyRoots.end());
+		unsigned done = 0;
+		for (unsigned root : dirtyRoots) {
+			if (root < done)
+				continue;
+			done = root + subtreeSizes[root];
+			for (unsigned p = root; p < done; ++p) {
+				if (parents[p] < 0)
+					worlds[p] = locals[p];
+				else
+					Multiply(locals[p].data, worlds[parents[p]].data, worlds[p].data);
+				dirty[p] = 0;
+				changed.push_back(nodeAt[p]);
+			}
+		}
+		dirtyRoots.clear();
+		return changed.size();
+	}
+
+	//Returns the ids whose world matrix the last Update recomputed, parents before children
+	inline const std::vector<unsigned>& GetChanged() const {
+		return changed;
+	}
+
+	//Returns the number of nodes
+	inline size_t Size() const {
+		return positionOf.size();
+	}
+
+	//Exchanges every node with another TransformHierarchy
+	void Swap(TransformHierarchy& other) {
+		locals.swap(other.locals);
+		worlds.swap(other.worlds);
+		parents.swap(other.parents);
+		subtreeSizes.swap(other.subtreeSizes);
+		nodeAt.swap(other.nodeAt);
+		dirty.swap(other.dirty);
+		positionOf.swap(other.positionOf);
+		parentIds.swap(other.parentIds);
+		dirtyRoots.swap(other.dirtyRoots);
+		changed.swap(other.changed);
+		std::swap(reorder, other.reorder);
+	}
+
+	//Removes every node
+	void Clear() {
+		TransformHierarchy empty;
+		Swap(empty);
+	}
+};
+#endif